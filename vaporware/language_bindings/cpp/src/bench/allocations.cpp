@@ -0,0 +1,49 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "allocations.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/*
+ * The replaced operator new counts every allocation; all other forms of new and
+ * delete are implemented by the standard-library in terms of these two.
+ */
+
+namespace {
+std::atomic<std::size_t> allocation_count(0);
+}
+
+void* operator new(std::size_t size) {
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	void* memory = std::malloc(size ? size : 1);
+	if (!memory) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+std::size_t allocations() {
+	return allocation_count.load(std::memory_order_relaxed);
+}
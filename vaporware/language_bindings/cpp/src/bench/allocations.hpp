@@ -0,0 +1,30 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ALLOCATIONS_HPP
+#define ALLOCATIONS_HPP
+
+#include <cstddef>
+
+/**
+ * @brief The number of heap-allocations of all threads since the start of the program.
+ *
+ * The benchmarks replace the global operator new to count them.
+ */
+std::size_t allocations();
+
+#endif // ALLOCATIONS_HPP
@@ -0,0 +1,1207 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "benchmarks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#include <boost/program_options.hpp>
+
+#include <sys/resource.h>
+
+#include "../lib/blend.hpp"
+#include "../lib/client.hpp"
+#include "../lib/easing.hpp"
+#include "../lib/cluster_client.hpp"
+#include "../lib/color_space.hpp"
+#include "../lib/concurrent_client.hpp"
+#include "../lib/frame_view.hpp"
+#include "../lib/layer_stack.hpp"
+#include "../lib/protocol.hpp"
+#include "../lib/static_frame.hpp"
+
+#include "allocations.hpp"
+#include "coroutines.hpp"
+#include "sink.hpp"
+
+namespace bpo = boost::program_options;
+using bench_clock = std::chrono::steady_clock;
+
+namespace {
+
+const std::string TOKEN = "sixteen letters.";
+
+/*
+ * Parses the options of a benchmark; returns false if the help was requested.
+ */
+bool parse_args(const std::vector<std::string>& args, const bpo::options_description& desc,
+		bpo::variables_map& vm) {
+	bpo::store(bpo::command_line_parser(args).options(desc).run(), vm);
+	bpo::notify(vm);
+	if (vm.count("help")) {
+		std::cout << desc << std::endl;
+		return false;
+	}
+	return true;
+}
+
+double to_us(bench_clock::duration d) {
+	return std::chrono::duration<double, std::micro>(d).count();
+}
+
+/*
+ * Prints mean, median, 99th percentile and maximum of some durations.
+ */
+void print_latencies(const std::string& name, std::vector<double> samples) {
+	if (samples.empty()) {
+		return;
+	}
+	std::sort(samples.begin(), samples.end());
+	double sum = 0;
+	for (auto s: samples) {
+		sum += s;
+	}
+	std::cout << name << ": mean " << sum / samples.size() << "µs"
+	          << ", median " << samples[samples.size() / 2] << "µs"
+	          << ", p99 " << samples[samples.size() * 99 / 100] << "µs"
+	          << ", max " << samples.back() << "µs" << std::endl;
+}
+
+/*
+ * Keeps the cpu busy for some time; this simulates the computation of an effect.
+ */
+void render(bench_clock::duration time) {
+	auto end = bench_clock::now() + time;
+	while (bench_clock::now() < end) {}
+}
+
+/*
+ * Waits until the sink didn't receive anything for some time and returns the
+ * number of bytes it received in total.
+ */
+std::size_t wait_for_sink(const sink& server) {
+	std::size_t bytes;
+	do {
+		bytes = server.bytes_received();
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	} while (bytes != server.bytes_received());
+	return bytes;
+}
+
+/*
+ * A static_frame for every third LED, as on a wall where only the LEDs of one color
+ * are animated.
+ */
+template<typename Indices>
+struct strided_frame;
+
+template<std::size_t... I>
+struct strided_frame<vlpp::detail::indices<I...>> {
+	using type = vlpp::static_frame<static_cast<uint16_t>(I * 3)...>;
+};
+
+using sparse_frame = strided_frame<vlpp::detail::make_indices<333>::type>::type;
+
+/*
+ * Runs the steps of many fades with an easing-curve, once through a std::function like
+ * the blinker did before, once with the curve inlined and once from its table.
+ */
+struct easing_run {
+	std::size_t fades;
+	int steps;
+	
+	template<typename Curve>
+	void operator()(Curve) const {
+		std::function<std::pair<double, double>(int, int)> ratio = [](int step, int total) {
+			double share = Curve::ease(static_cast<double>(step) / total);
+			return std::make_pair(share, 1 - share);
+		};
+		run("std::function", [&](int step) {
+			return vlpp::blend_weight(ratio(step, steps).first);
+		});
+		run("template     ", [&](int step) {
+			return vlpp::easing::weight<Curve>(step, steps);
+		});
+		run("table        ", [&](int step) {
+			return vlpp::easing::lookup<Curve>(step, steps);
+		});
+	}
+	
+	template<typename Weight>
+	void run(const char* name, Weight weight) const {
+		const vlpp::rgba_color from(255, 128, 0);
+		const vlpp::rgba_color to(0, 64, 255);
+		unsigned checksum = 0;
+		auto start = bench_clock::now();
+		for (std::size_t fade = 0; fade < fades; ++fade) {
+			for (int step = 0; step < steps; ++step) {
+				checksum += vlpp::blend(from, to, weight(step)).red;
+			}
+		}
+		auto ns = std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+		std::cout << "  " << name << ": " << ns / static_cast<double>(fades * steps)
+		          << "ns per step (checksum " << checksum << ")\n";
+	}
+};
+
+} // anonymous namespace
+
+int bench_flush(const std::vector<std::string>& args) {
+	std::size_t frames;
+	uint16_t leds;
+	unsigned render_us;
+	std::size_t throughput;
+	std::size_t watermark;
+	
+	bpo::options_description desc("flush: measures how long flush() blocks the render-thread");
+	desc.add_options()
+		("help,h", "print this help")
+		("frames,n", bpo::value<std::size_t>(&frames)->default_value(1000), "number of frames")
+		("leds,l", bpo::value<uint16_t>(&leds)->default_value(1000), "LEDs per frame")
+		("render-time,r", bpo::value<unsigned>(&render_us)->default_value(1000),
+		 "simulated render-time per frame in µs")
+		("throughput,b", bpo::value<std::size_t>(&throughput)->default_value(0),
+		 "throughput of the server in bytes/s (0 = unlimited)")
+		("watermark,w", bpo::value<std::size_t>(&watermark)->default_value(vlpp::client::DEFAULT_WATERMARK),
+		 "capacity of the command-buffer")
+		("async,a", "use asynchronous flushing");
+	bpo::variables_map vm;
+	if (!parse_args(args, desc, vm)) {
+		return 0;
+	}
+	bool async = vm.count("async");
+	
+	sink server(throughput);
+	vlpp::client client("127.0.0.1", TOKEN, server.port());
+	client.set_watermark(watermark);
+	client.set_async(async);
+	
+	std::vector<double> flush_times;
+	flush_times.reserve(frames);
+	auto start = bench_clock::now();
+	for (std::size_t frame = 0; frame < frames; ++frame) {
+		render(std::chrono::microseconds(render_us));
+		vlpp::rgba_color col(uint8_t(frame), uint8_t(frame >> 8), 0);
+		for (uint16_t led = 0; led < leds; ++led) {
+			client.set_led(led, col);
+		}
+		auto before = bench_clock::now();
+		client.flush();
+		flush_times.push_back(to_us(bench_clock::now() - before));
+	}
+	client.set_async(false);
+	auto total = bench_clock::now() - start;
+	
+	std::cout << (async ? "async" : "sync") << ", " << frames << " frames à " << leds
+	          << " LEDs, " << render_us << "µs render-time\n";
+	print_latencies("flush()", flush_times);
+	std::cout << "frames/s: " << frames / std::chrono::duration<double>(total).count()
+	          << std::endl;
+	return 0;
+}
+
+int bench_delta(const std::vector<std::string>& args) {
+	std::size_t frames;
+	uint16_t leds;
+	uint16_t changes;
+	
+	bpo::options_description desc("delta: compares the bytes per frame with and without delta-mode");
+	desc.add_options()
+		("help,h", "print this help")
+		("frames,n", bpo::value<std::size_t>(&frames)->default_value(1000), "number of frames")
+		("leds,l", bpo::value<uint16_t>(&leds)->default_value(1000), "LEDs per frame")
+		("changes,c", bpo::value<uint16_t>(&changes)->default_value(50),
+		 "LEDs that change their color per frame");
+	bpo::variables_map vm;
+	if (!parse_args(args, desc, vm)) {
+		return 0;
+	}
+	
+	for (bool delta: {false, true}) {
+		sink server;
+		vlpp::client client("127.0.0.1", TOKEN, server.port());
+		client.set_delta_mode(delta);
+		std::size_t start = wait_for_sink(server);
+		for (std::size_t frame = 0; frame < frames; ++frame) {
+			// a static scene where only a moving window of LEDs changes; the colors differ
+			// per LED, so that the full frames can't be merged into a few ranges:
+			for (uint16_t led = 0; led < leds; ++led) {
+				bool changed = (led + frame) % leds < changes;
+				client.set_led(led, changed ? vlpp::rgba_color(uint8_t(frame), uint8_t(led), 0)
+				                            : vlpp::rgba_color(0, uint8_t(led), 255));
+			}
+			client.flush();
+		}
+		std::size_t bytes = wait_for_sink(server) - start;
+		std::cout << (delta ? "delta" : "full ") << ": " << bytes / frames
+		          << " bytes/frame" << std::endl;
+	}
+	return 0;
+}
+
+int bench_compaction(const std::vector<std::string>& args) {
+	std::size_t frames;
+	uint16_t leds;
+	unsigned writes;
+	
+	bpo::options_description desc("compaction: compares the bytes and time per frame with and "
+	                               "without compaction if every LED is written several times");
+	desc.add_options()
+		("help,h", "print this help")
+		("frames,n", bpo::value<std::size_t>(&frames)->default_value(1000), "number of frames")
+		("leds,l", bpo::value<uint16_t>(&leds)->default_value(1000), "LEDs per frame")
+		("writes,k", bpo::value<unsigned>(&writes)->default_value(4),
+		 "writes per LED and frame");
+	bpo::variables_map vm;
+	if (!parse_args(args, desc, vm)) {
+		return 0;
+	}
+	
+	for (bool compact: {false, true}) {
+		sink server;
+		vlpp::client client("127.0.0.1", TOKEN, server.port());
+		client.set_compaction(compact);
+		std::size_t start = wait_for_sink(server);
+		auto start_time = bench_clock::now();
+		for (std::size_t frame = 0; frame < frames; ++frame) {
+			// several layers that overwrite each other, like a background with effects:
+			for (unsigned layer = 0; layer < writes; ++layer) {
+				for (uint16_t led = 0; led < leds; ++led) {
+					client.set_led(led, vlpp::rgba_color(uint8_t(frame), uint8_t(layer),
+					                                     uint8_t(led)));
+				}
+			}
+			client.flush();
+		}
+		auto total = bench_clock::now() - start_time;
+		std::size_t bytes = wait_for_sink(server) - start;
+		std::cout << (compact ? "compacted  " : "uncompacted") << ": " << bytes / frames
+		          << " bytes/frame, "
+		          << std::chrono::duration<double, std::micro>(total).count() / frames
+		          << "µs/frame" << std::endl;
+	}
+	return 0;
+}
+
+int bench_encoding(const std::vector<std::string>& args) {
+	std::size_t frames;
+	uint16_t leds;
+	uint16_t segment;
+	
+	bpo::options_description desc("encoding: compares the bytes per frame of typical scenes "
+	                               "with one SET_LED per LED");
+	desc.add_options()
+		("help,h", "print this help")
+		("frames,n", bpo::value<std::size_t>(&frames)->default_value(1000), "number of frames")
+		("leds,l", bpo::value<uint16_t>(&leds)->default_value(1000), "LEDs per frame")
+		("segment,s", bpo::value<uint16_t>(&segment)->default_value(10),
+		 "length of the segments of the chase");
+	bpo::variables_map vm;
+	if (!parse_args(args, desc, vm)) {
+		return 0;
+	}
+	if (segment == 0) {
+		std::cerr << "the segments must not be empty" << std::endl;
+		return 1;
+	}
+	
+	// a fill and a chase, written LED by LED and as a whole:
+	std::vector<vlpp::rgba_color> colors(leds);
+	const std::vector<std::pair<std::string, bool>> scenes = {
+		{"fill, set_led() ", false}, {"fill, set_leds()", true},
+		{"chase, set_led() ", false}, {"chase, set_leds()", true}
+	};
+	for (std::size_t scene = 0; scene < scenes.size(); ++scene) {
+		sink server;
+		vlpp::client client("127.0.0.1", TOKEN, server.port());
+		std::size_t start = wait_for_sink(server);
+		for (std::size_t frame = 0; frame < frames; ++frame) {
+			for (uint16_t led = 0; led < leds; ++led) {
+				uint8_t level = scene < 2 ? uint8_t(frame)
+				                          : uint8_t((led + frame) / segment % 2 * 255);
+				colors[led] = vlpp::rgba_color(level, 0, 0);
+			}
+			if (scenes[scene].second) {
+				client.set_leds(0, colors.data(), colors.size());
+			}
+			else {
+				for (uint16_t led = 0; led < leds; ++led) {
+					client.set_led(led, colors[led]);
+				}
+			}
+			client.flush();
+		}
+		std::size_t bytes = wait_for_sink(server) - start;
+		std::cout << scenes[scene].first << ": " << bytes / frames << " bytes/frame, "
+		          << 7 * std::size_t(leds) + 1 << " with SET_LED only" << std::endl;
+	}
+	return 0;
+}
+
+int bench_realtime(const std::vector<std::string>& args) {
+	std::size_t frames;
+	uint16_t leds;
+	unsigned cpu;
+	
+	bpo::options_description desc("realtime: counts the heap-allocations per frame of the "
+	                               "noexcept-interface; fails if there are any");
+	desc.add_options()
+		("help,h", "print this help")
+		("frames,n", bpo::value<std::size_t>(&frames)->default_value(10000), "number of frames")
+		("leds,l", bpo::value<uint16_t>(&leds)->default_value(1000), "LEDs per frame")
+		("async,a", "use asynchronous flushing")
+		("delta,d", "use delta-mode")
+		("realtime,r", "use realtime-mode")
+		("cpu,c", bpo::value<unsigned>(&cpu)->default_value(0), "the CPU of the worker-thread");
+	bpo::variables_map vm;
+	if (!parse_args(args, desc, vm)) {
+		return 0;
+	}
+	
+	sink server;
+	vlpp::client client("127.0.0.1", TOKEN, server.port());
+	client.set_async(vm.count("async"));
+	client.set_delta_mode(vm.count("delta"));
+	client.set_realtime(vm.count("realtime"), cpu);
+	std::vector<vlpp::rgba_color> colors(leds);
+	std::vector<double> flush_times;
+	flush_times.reserve(frames);
+	
+	auto send_frame = [&](std::size_t frame) {
+		for (uint16_t led = 0; led < leds; ++led) {
+			colors[led] = vlpp::rgba_color(uint8_t(frame), uint8_t(led), 0);
+		}
+		// one LED at a time and a whole array, to cover both paths:
+		if (client.try_set_led(0, vlpp::rgba_color(0, 0, uint8_t(frame)))
+				!= vlpp::client::status::ok
+				|| client.try_set_leds(1, colors.data() + 1, colors.size() - 1)
+				!= vlpp::client::status::ok) {
+			throw std::runtime_error("setting the LEDs failed");
+		}
+		auto start = bench_clock::now();
+		if (client.try_flush() != vlpp::client::status::ok) {
+			throw std::runtime_error("flush failed");
+		}
+		flush_times.push_back(std::chrono::duration<double, std::micro>(
+			bench_clock::now() - start).count());
+	};
+	// the first frames may still set up the socket and the handlers of asio:
+	enum { WARMUP_FRAMES = 10 };
+	for (std::size_t frame = 0; frame < WARMUP_FRAMES; ++frame) {
+		send_frame(frame);
+	}
+	flush_times.clear();
+	std::size_t before = allocations();
+	for (std::size_t frame = 0; frame < frames; ++frame) {
+		send_frame(frame);
+	}
+	std::size_t count = allocations() - before;
+	client.set_async(false);
+	client.set_realtime(false);
+	
+	print_latencies("flush()", flush_times);
+	std::cout << "allocations: " << count << " in " << frames << " frames" << std::endl;
+	return count ? 1 : 0;
+}
+
+int bench_cluster(const std::vector<std::string>& args) {
+	std::size_t frames;
+	std::size_t shards;
+	uint16_t leds;
+	std::size_t throughput;
+	
+	bpo::options_description desc("cluster: compares a vlpp::cluster_client with flushing one "
+	                               "vlpp::client per server after another");
+	desc.add_options()
+		("help,h", "print this help")
+		("frames,n", bpo::value<std::size_t>(&frames)->default_value(200), "number of frames")
+		("shards,s", bpo::value<std::size_t>(&shards)->default_value(4), "number of servers")
+		("leds,l", bpo::value<uint16_t>(&leds)->default_value(2000), "LEDs per server")
+		("throughput,b", bpo::value<std::size_t>(&throughput)->default_value(2000000),
+		 "throughput of every server in bytes/s (0 = unlimited)");
+	bpo::variables_map vm;
+	if (!parse_args(args, desc, vm)) {
+		return 0;
+	}
+	if (shards == 0 || shards * leds > vlpp::LED_COUNT) {
+		std::cerr << "the LEDs of the servers must fit into the LED-IDs" << std::endl;
+		return 1;
+	}
+	
+	std::vector<std::unique_ptr<sink>> servers;
+	for (std::size_t i = 0; i < shards; ++i) {
+		servers.emplace_back(new sink(throughput));
+	}
+	std::vector<vlpp::rgba_color> colors(shards * leds);
+	auto render_frame = [&](std::size_t frame) {
+		for (std::size_t led = 0; led < colors.size(); ++led) {
+			colors[led] = vlpp::rgba_color(uint8_t(frame), uint8_t(led), uint8_t(led >> 8));
+		}
+	};
+	auto report = [&](const std::string& name, bench_clock::duration total) {
+		std::cout << name << ": " << std::chrono::duration<double, std::milli>(total).count() / frames
+		          << "ms/frame" << std::endl;
+	};
+	
+	{
+		std::vector<vlpp::client> clients;
+		for (auto& server: servers) {
+			clients.emplace_back("127.0.0.1", TOKEN, server->port());
+		}
+		auto start = bench_clock::now();
+		for (std::size_t frame = 0; frame < frames; ++frame) {
+			render_frame(frame);
+			for (std::size_t i = 0; i < shards; ++i) {
+				clients[i].set_leds(static_cast<uint16_t>(i * leds), &colors[i * leds], leds);
+				clients[i].flush();
+			}
+		}
+		report("sequential", bench_clock::now() - start);
+	}
+	{
+		std::vector<vlpp::cluster_client::shard> table;
+		for (std::size_t i = 0; i < shards; ++i) {
+			table.push_back({static_cast<uint16_t>(i * leds),
+				static_cast<uint16_t>((i + 1) * leds - 1), "127.0.0.1", servers[i]->port()});
+		}
+		vlpp::cluster_client cluster(table, TOKEN);
+		auto start = bench_clock::now();
+		for (std::size_t frame = 0; frame < frames; ++frame) {
+			render_frame(frame);
+			cluster.set_leds(0, colors.data(), colors.size());
+			cluster.flush();
+		}
+		report("cluster   ", bench_clock::now() - start);
+	}
+	return 0;
+}
+
+int bench_skew(const std::vector<std::string>& args) {
+	std::size_t frames;
+	std::size_t shards;
+	uint16_t leds;
+	unsigned latency;
+	unsigned delay;
+	unsigned interval;
+	
+	bpo::options_description desc("skew: compares how far apart servers with different "
+	                               "latencies and clocks execute the frames of a "
+	                               "vlpp::cluster_client, with and without timed strobes");
+	desc.add_options()
+		("help,h", "print this help")
+		("frames,n", bpo::value<std::size_t>(&frames)->default_value(100), "number of frames")
+		("shards,s", bpo::value<std::size_t>(&shards)->default_value(3), "number of servers")
+		("leds,l", bpo::value<uint16_t>(&leds)->default_value(500), "LEDs per server")
+		("latency,L", bpo::value<unsigned>(&latency)->default_value(1000),
+		 "the server i has a one-way-latency of i times this many µs")
+		("delay,d", bpo::value<unsigned>(&delay)->default_value(20000),
+		 "presentation-delay of the timed strobes in µs")
+		("interval,i", bpo::value<unsigned>(&interval)->default_value(40),
+		 "time between two frames in ms");
+	bpo::variables_map vm;
+	if (!parse_args(args, desc, vm)) {
+		return 0;
+	}
+	if (shards == 0 || shards * leds > vlpp::LED_COUNT) {
+		std::cerr << "the LEDs of the servers must fit into the LED-IDs" << std::endl;
+		return 1;
+	}
+	
+	std::vector<vlpp::rgba_color> colors(shards * leds);
+	// every server has another clock, far away from the local one:
+	auto clock_offset = [](std::size_t shard) {
+		return std::chrono::nanoseconds(std::chrono::milliseconds(1234)) * static_cast<int>(shard);
+	};
+	auto run = [&](const std::string& name, bool timed) {
+		std::vector<std::unique_ptr<strobe_sink>> servers;
+		std::vector<vlpp::cluster_client::shard> table;
+		for (std::size_t i = 0; i < shards; ++i) {
+			servers.emplace_back(new strobe_sink(clock_offset(i),
+				std::chrono::microseconds(latency) * static_cast<int>(i)));
+			table.push_back({static_cast<uint16_t>(i * leds),
+				static_cast<uint16_t>((i + 1) * leds - 1), "127.0.0.1", servers[i]->port()});
+		}
+		vlpp::cluster_client cluster(table, TOKEN);
+		if (timed) {
+			auto estimates = cluster.sync_clocks();
+			for (std::size_t i = 0; i < shards; ++i) {
+				std::cout << "server " << i << ": offset-error "
+				          << to_us(estimates[i].offset - clock_offset(i)) << "µs, round-trip "
+				          << to_us(estimates[i].round_trip) << "µs" << std::endl;
+			}
+			cluster.set_presentation_delay(std::chrono::microseconds(delay));
+		}
+		for (std::size_t frame = 0; frame < frames; ++frame) {
+			for (std::size_t led = 0; led < colors.size(); ++led) {
+				colors[led] = vlpp::rgba_color(uint8_t(frame), uint8_t(led), uint8_t(led >> 8));
+			}
+			cluster.set_leds(0, colors.data(), colors.size());
+			cluster.flush();
+			std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+		}
+		// wait until the last strobes have been executed:
+		auto deadline = bench_clock::now() + std::chrono::seconds(5);
+		std::vector<std::vector<bench_clock::time_point>> strobes(shards);
+		for (std::size_t i = 0; i < shards; ++i) {
+			while ((strobes[i] = servers[i]->strobes()).size() < frames
+					&& bench_clock::now() < deadline) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			if (strobes[i].size() < frames) {
+				throw std::runtime_error("server " + std::to_string(i) + " lost strobes");
+			}
+		}
+		std::vector<double> skews;
+		for (std::size_t frame = 0; frame < frames; ++frame) {
+			auto first = strobes[0][frame];
+			auto last = first;
+			for (auto& times: strobes) {
+				first = std::min(first, times[frame]);
+				last = std::max(last, times[frame]);
+			}
+			skews.push_back(to_us(last - first));
+		}
+		print_latencies(name, skews);
+	};
+	
+	run("skew, plain strobes", false);
+	run("skew, timed strobes", true);
+	return 0;
+}
+
+int bench_concurrent(const std::vector<std::string>& args) {
+	unsigned threads;
+	unsigned seconds;
+	uint16_t leds;
+	
+	bpo::options_description desc("concurrent: measures the updates/s of many producer-threads");
+	desc.add_options()
+		("help,h", "print this help")
+		("threads,j", bpo::value<unsigned>(&threads)->default_value(4), "number of producers")
+		("seconds,s", bpo::value<unsigned>(&seconds)->default_value(2), "duration")
+		("leds,l", bpo::value<uint16_t>(&leds)->default_value(10), "LEDs per producer")
+		("mutex,m", "share a vlpp::client with a mutex and flush after every update");
+	bpo::variables_map vm;
+	if (!parse_args(args, desc, vm)) {
+		return 0;
+	}
+	bool use_mutex = vm.count("mutex");
+	
+	sink server;
+	vlpp::client shared_client;
+	std::mutex shared_client_mutex;
+	vlpp::concurrent_client concurrent;
+	if (use_mutex) {
+		shared_client = vlpp::client("127.0.0.1", TOKEN, server.port());
+	}
+	else {
+		concurrent = vlpp::concurrent_client("127.0.0.1", TOKEN, server.port());
+	}
+	
+	std::atomic<bool> stop(false);
+	std::atomic<std::size_t> updates(0);
+	std::vector<std::thread> producers;
+	for (unsigned t = 0; t < threads; ++t) {
+		producers.emplace_back([&, t] {
+			std::vector<uint16_t> ids;
+			for (uint16_t i = 0; i < leds; ++i) {
+				ids.push_back(static_cast<uint16_t>(t * leds + i));
+			}
+			std::size_t count = 0;
+			while (!stop) {
+				vlpp::rgba_color col(uint8_t(count), uint8_t(t), 0);
+				if (use_mutex) {
+					std::lock_guard<std::mutex> lock(shared_client_mutex);
+					shared_client.set_leds(ids, col);
+					shared_client.flush();
+				}
+				else {
+					concurrent.set_leds(ids, col);
+				}
+				++count;
+			}
+			updates += count;
+		});
+	}
+	std::this_thread::sleep_for(std::chrono::seconds(seconds));
+	stop = true;
+	for (auto& producer: producers) {
+		producer.join();
+	}
+	std::cout << (use_mutex ? "mutex" : "lock-free") << ", " << threads << " producers: "
+	          << updates / seconds << " updates/s" << std::endl;
+	return 0;
+}
+
+int bench_coroutines(const std::vector<std::string>& args) {
+	effect_load load;
+	unsigned fps;
+	
+	bpo::options_description desc("coroutines: compares effect-tasks that await async_flush() "
+	                               "on one thread with one thread per task that calls flush(), "
+	                               "like the blinker");
+	desc.add_options()
+		("help,h", "print this help")
+		("tasks,t", bpo::value<std::size_t>(&load.tasks)->default_value(200), "number of tasks")
+		("frames,n", bpo::value<std::size_t>(&load.frames)->default_value(100),
+		 "number of frames per task")
+		("leds,l", bpo::value<uint16_t>(&load.leds)->default_value(20), "LEDs per task")
+		("fps,f", bpo::value<unsigned>(&fps)->default_value(50), "frames per second of every task");
+	bpo::variables_map vm;
+	if (!parse_args(args, desc, vm)) {
+		return 0;
+	}
+	if (load.tasks == 0 || load.tasks * load.leds > vlpp::LED_COUNT || fps == 0) {
+		std::cerr << "the LEDs of the tasks must fit into the LED-IDs" << std::endl;
+		return 1;
+	}
+	load.period = std::chrono::microseconds(1000000 / fps);
+	
+	sink server;
+	load.port = server.port();
+	auto cpu_time = [] {
+		rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return to_us(std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+			+ std::chrono::microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec));
+	};
+	auto report = [&](const std::string& name, std::size_t threads, double cpu,
+			const std::vector<double>& lateness) {
+		std::cout << name << ": " << threads << " threads, cpu " << cpu / 1000 << "ms" << std::endl;
+		print_latencies(name + ", lateness", lateness);
+	};
+	
+	{
+		double cpu = cpu_time();
+		std::vector<double> lateness;
+		std::mutex lateness_mutex;
+		std::vector<std::thread> threads;
+		for (std::size_t i = 0; i < load.tasks; ++i) {
+			threads.emplace_back([&, i] {
+				vlpp::client client("127.0.0.1", TOKEN, load.port);
+				std::vector<vlpp::rgba_color> colors(load.leds);
+				std::vector<double> samples;
+				auto deadline = bench_clock::now();
+				for (std::size_t frame = 0; frame < load.frames; ++frame) {
+					for (std::size_t led = 0; led < colors.size(); ++led) {
+						colors[led] = vlpp::rgba_color(uint8_t(frame), uint8_t(led), uint8_t(i));
+					}
+					client.set_leds(static_cast<uint16_t>(i * load.leds), colors.data(), colors.size());
+					client.flush();
+					samples.push_back(to_us(bench_clock::now() - deadline));
+					deadline += load.period;
+					std::this_thread::sleep_until(deadline);
+				}
+				std::lock_guard<std::mutex> lock(lateness_mutex);
+				lateness.insert(lateness.end(), samples.begin(), samples.end());
+			});
+		}
+		for (auto& thread: threads) {
+			thread.join();
+		}
+		report("threads   ", load.tasks, cpu_time() - cpu, lateness);
+	}
+	if (!coroutines_available()) {
+		std::cerr << "the benchmarks were built without C++20-coroutines" << std::endl;
+		return 1;
+	}
+	{
+		double cpu = cpu_time();
+		auto lateness = run_coroutine_effects(load);
+		report("coroutines", 1, cpu_time() - cpu, lateness);
+	}
+	return 0;
+}
+
+int bench_latency(const std::vector<std::string>& args) {
+	std::size_t frames;
+	uint16_t leds;
+	unsigned render_us;
+	
+	bpo::options_description desc("latency: compares the time from flush() until the frame "
+		"has arrived over tcp and udp");
+	desc.add_options()
+		("help,h", "print this help")
+		("frames,n", bpo::value<std::size_t>(&frames)->default_value(1000), "number of frames")
+		("leds,l", bpo::value<uint16_t>(&leds)->default_value(1000), "LEDs per frame")
+		("render-time,r", bpo::value<unsigned>(&render_us)->default_value(1000),
+		 "simulated render-time per frame in µs");
+	bpo::variables_map vm;
+	if (!parse_args(args, desc, vm)) {
+		return 0;
+	}
+	
+	std::vector<vlpp::rgba_color> colors(leds);
+	auto next_frame = [&colors](std::size_t frame) {
+		// all colors differ, so the frame is sent as one span:
+		for (std::size_t led = 0; led < colors.size(); ++led) {
+			colors[led] = vlpp::rgba_color(uint8_t(frame), uint8_t(led), uint8_t(led >> 8));
+		}
+	};
+	auto measure = [&](vlpp::client& client, const std::function<bool(std::size_t)>& arrived) {
+		std::vector<double> latencies;
+		latencies.reserve(frames);
+		for (std::size_t frame = 0; frame < frames; ++frame) {
+			render(std::chrono::microseconds(render_us));
+			next_frame(frame);
+			client.set_leds(0, colors.data(), colors.size());
+			auto before = bench_clock::now();
+			client.flush();
+			while (!arrived(frame)) {
+				std::this_thread::yield();
+			}
+			latencies.push_back(to_us(bench_clock::now() - before));
+		}
+		return latencies;
+	};
+	
+	std::cout << frames << " frames à " << leds << " LEDs, " << render_us << "µs render-time\n";
+	{
+		sink server;
+		vlpp::client client("127.0.0.1", TOKEN, server.port());
+		std::size_t start = wait_for_sink(server);
+		// a SET_LEDS-command and the strobe:
+		std::size_t frame_size = 5 + leds * sizeof(vlpp::rgba_color) + 1;
+		print_latencies("tcp", measure(client, [&](std::size_t frame) {
+			return server.bytes_received() >= start + (frame + 1) * frame_size;
+		}));
+	}
+	{
+		datagram_sink server;
+		vlpp::client client("udp:127.0.0.1", TOKEN, server.port());
+		print_latencies("udp", measure(client, [&](std::size_t frame) {
+			return server.frames_received() > frame;
+		}));
+	}
+	return 0;
+}
+
+int bench_submit(const std::vector<std::string>& args) {
+	std::size_t frames;
+	std::size_t leds;
+	
+	bpo::options_description desc("submit: compares set_leds() and flush() with the zero-copy "
+		"submit() for large frames");
+	desc.add_options()
+		("help,h", "print this help")
+		("frames,n", bpo::value<std::size_t>(&frames)->default_value(500), "number of frames")
+		("leds,l", bpo::value<std::size_t>(&leds)->default_value(vlpp::LED_COUNT), "LEDs per frame");
+	bpo::variables_map vm;
+	if (!parse_args(args, desc, vm)) {
+		return 0;
+	}
+	if (leds == 0 || leds > vlpp::LED_COUNT) {
+		throw std::invalid_argument("invalid number of LEDs");
+	}
+	
+	// a video-wall: two framebuffers that are rendered alternately
+	std::vector<std::vector<vlpp::rgba_color>> buffers(2, std::vector<vlpp::rgba_color>(leds));
+	for (std::size_t i = 0; i < leds; ++i) {
+		buffers[0][i] = vlpp::rgba_color(uint8_t(i), uint8_t(i >> 8), 0);
+		buffers[1][i] = vlpp::rgba_color(0, uint8_t(i), uint8_t(i >> 8));
+	}
+	
+	std::cout << frames << " frames à " << leds << " LEDs\n";
+	for (bool zero_copy: {false, true}) {
+		sink server;
+		vlpp::client client("127.0.0.1", TOKEN, server.port());
+		vlpp::frame_view view;
+		std::vector<double> times;
+		times.reserve(frames);
+		auto start = bench_clock::now();
+		for (std::size_t frame = 0; frame < frames; ++frame) {
+			auto& colors = buffers[frame % 2];
+			auto before = bench_clock::now();
+			if (zero_copy) {
+				view.clear();
+				view.add(0, colors);
+				client.submit(view);
+			}
+			else {
+				client.set_leds(0, colors.data(), colors.size());
+				client.flush();
+			}
+			times.push_back(to_us(bench_clock::now() - before));
+		}
+		auto total = bench_clock::now() - start;
+		print_latencies(zero_copy ? "submit()          " : "set_leds()+flush()", times);
+		std::cout << "MB/s: " << static_cast<double>(frames * leds * sizeof(vlpp::rgba_color))
+		             / std::chrono::duration<double>(total).count() / 1e6 << std::endl;
+	}
+	return 0;
+}
+
+int bench_static(const std::vector<std::string>& args) {
+	std::size_t frames;
+	
+	bpo::options_description desc("static: compares set_led() and flush() with a static_frame "
+		"for a set of LEDs that is fixed at compile time");
+	desc.add_options()
+		("help,h", "print this help")
+		("frames,n", bpo::value<std::size_t>(&frames)->default_value(2000), "number of frames");
+	bpo::variables_map vm;
+	if (!parse_args(args, desc, vm)) {
+		return 0;
+	}
+	
+	std::vector<std::vector<vlpp::rgba_color>> buffers(2,
+		std::vector<vlpp::rgba_color>(sparse_frame::size()));
+	for (std::size_t i = 0; i < sparse_frame::size(); ++i) {
+		buffers[0][i] = vlpp::rgba_color(uint8_t(i), uint8_t(i >> 8), 0);
+		buffers[1][i] = vlpp::rgba_color(0, uint8_t(i), uint8_t(i >> 8));
+	}
+	
+	std::cout << frames << " frames à " << sparse_frame::size() << " LEDs, every third LED, "
+	          << sparse_frame::bytes() << " bytes per frame\n";
+	for (bool fixed: {false, true}) {
+		sink server;
+		vlpp::client client("127.0.0.1", TOKEN, server.port());
+		sparse_frame frame;
+		std::vector<double> serialize;
+		std::vector<double> times;
+		serialize.reserve(frames);
+		times.reserve(frames);
+		for (std::size_t n = 0; n < frames; ++n) {
+			auto& colors = buffers[n % 2];
+			auto before = bench_clock::now();
+			if (fixed) {
+				frame.assign(colors.data());
+				serialize.push_back(to_us(bench_clock::now() - before));
+				client.submit(frame);
+			}
+			else {
+				for (std::size_t slot = 0; slot < sparse_frame::size(); ++slot) {
+					client.set_led(sparse_frame::id(slot), colors[slot]);
+				}
+				serialize.push_back(to_us(bench_clock::now() - before));
+				client.flush();
+			}
+			times.push_back(to_us(bench_clock::now() - before));
+		}
+		print_latencies(fixed ? "static_frame: colors  " : "set_led():    commands", serialize);
+		print_latencies(fixed ? "static_frame: frame   " : "set_led():    frame   ", times);
+	}
+	return 0;
+}
+
+int bench_blend(const std::vector<std::string>& args) {
+	std::size_t leds;
+	std::size_t fades;
+	int steps;
+	
+	bpo::options_description desc("blend: checks the vectorized blend-kernel against the "
+		"reference and compares the throughput of fades");
+	desc.add_options()
+		("help,h", "print this help")
+		("leds,l", bpo::value<std::size_t>(&leds)->default_value(vlpp::LED_COUNT), "LEDs per frame")
+		("fades,n", bpo::value<std::size_t>(&fades)->default_value(20), "number of fades")
+		("steps,s", bpo::value<int>(&steps)->default_value(255), "steps per fade");
+	bpo::variables_map vm;
+	if (!parse_args(args, desc, vm)) {
+		return 0;
+	}
+	if (leds == 0 || steps < 1) {
+		throw std::invalid_argument("invalid number of LEDs or steps");
+	}
+	
+	std::mt19937 generator(42);
+	std::uniform_int_distribution<unsigned> byte(0, UINT8_MAX);
+	auto random_colors = [&](std::size_t count) {
+		std::vector<vlpp::rgba_color> colors(count);
+		for (auto& col: colors) {
+			col = vlpp::rgba_color(uint8_t(byte(generator)), uint8_t(byte(generator)),
+				uint8_t(byte(generator)), uint8_t(byte(generator)));
+		}
+		return colors;
+	};
+	
+	// every weight, with a length that leaves a rest for the scalar part of the kernels:
+	std::cout << "kernel: " << vlpp::blend_kernel() << std::endl;
+	auto from = random_colors(leds + 7);
+	auto to = random_colors(leds + 7);
+	std::vector<vlpp::rgba_color> result(from.size());
+	for (uint16_t weight = 0; weight <= vlpp::BLEND_ONE; ++weight) {
+		vlpp::blend(from.data(), to.data(), result.data(), result.size(), weight);
+		for (std::size_t i = 0; i < result.size(); ++i) {
+			if (result[i] != vlpp::blend(from[i], to[i], weight)) {
+				std::cout << "mismatch at weight " << weight << ", LED " << i << ": " << result[i]
+				          << " instead of " << vlpp::blend(from[i], to[i], weight) << std::endl;
+				return 1;
+			}
+		}
+	}
+	std::cout << "bit-exact for all weights" << std::endl;
+	
+	from.resize(leds);
+	to.resize(leds);
+	result.resize(leds);
+	std::cout << fades << " fades à " << steps << " steps of " << leds << " LEDs\n";
+	for (int method = 0; method < 3; ++method) {
+		unsigned checksum = 0;
+		auto start = bench_clock::now();
+		for (std::size_t fade = 0; fade < fades; ++fade) {
+			for (int step = 0; step < steps; ++step) {
+				double p_new = static_cast<double>(step) / steps;
+				double p_old = 1 - p_new;
+				auto weight = vlpp::blend_weight(p_new);
+				switch (method) {
+					case 0:
+						// the former blending of the blinker:
+						for (std::size_t i = 0; i < leds; ++i) {
+							result[i] = vlpp::rgba_color(
+								uint8_t(from[i].red * p_old + to[i].red * p_new),
+								uint8_t(from[i].green * p_old + to[i].green * p_new),
+								uint8_t(from[i].blue * p_old + to[i].blue * p_new),
+								uint8_t(from[i].alpha * p_old + to[i].alpha * p_new));
+						}
+						break;
+					case 1:
+						for (std::size_t i = 0; i < leds; ++i) {
+							result[i] = vlpp::blend(from[i], to[i], weight);
+						}
+						break;
+					default:
+						vlpp::blend(from.data(), to.data(), result.data(), leds, weight);
+				}
+				checksum += result[static_cast<std::size_t>(step) % leds].red;
+			}
+		}
+		auto seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+		const char* names[] = {"double   ", "reference", "kernel   "};
+		std::cout << names[method] << ": " << static_cast<double>(fades * steps * leds) / seconds / 1e6
+		          << " million LEDs/s (checksum " << checksum << ")" << std::endl;
+	}
+	return 0;
+}
+
+int bench_easing(const std::vector<std::string>& args) {
+	std::size_t fades;
+	int steps;
+	
+	bpo::options_description desc("easing: compares the color-ratio through a std::function "
+		"with inlined easing-curves and their tables");
+	desc.add_options()
+		("help,h", "print this help")
+		("fades,n", bpo::value<std::size_t>(&fades)->default_value(20000), "number of fades")
+		("steps,s", bpo::value<int>(&steps)->default_value(255), "steps per fade");
+	bpo::variables_map vm;
+	if (!parse_args(args, desc, vm)) {
+		return 0;
+	}
+	if (steps < 1) {
+		throw std::invalid_argument("invalid number of steps");
+	}
+	
+	std::cout << fades << " fades à " << steps << " steps\n";
+	using vlpp::easing::curve;
+	for (auto c: {curve::linear, curve::cubic, curve::sine, curve::exponential, curve::perceptual}) {
+		std::cout << vlpp::easing::to_string(c) << ":\n";
+		vlpp::easing::visit(c, easing_run{fades, steps});
+	}
+	std::cout << std::flush;
+	return 0;
+}
+
+int bench_colorspace(const std::vector<std::string>& args) {
+	std::size_t leds;
+	std::size_t frames;
+	
+	bpo::options_description desc("colorspace: checks the round-trips through the color-spaces "
+		"and compares the throughput of interpolations in them");
+	desc.add_options()
+		("help,h", "print this help")
+		("leds,l", bpo::value<std::size_t>(&leds)->default_value(10000), "LEDs per frame")
+		("frames,n", bpo::value<std::size_t>(&frames)->default_value(100), "number of frames");
+	bpo::variables_map vm;
+	if (!parse_args(args, desc, vm)) {
+		return 0;
+	}
+	if (leds == 0) {
+		throw std::invalid_argument("invalid number of LEDs");
+	}
+	
+	std::mt19937 generator(42);
+	std::uniform_int_distribution<unsigned> byte(0, UINT8_MAX);
+	auto random_colors = [&](std::size_t count) {
+		std::vector<vlpp::rgba_color> colors(count);
+		for (auto& col: colors) {
+			col = vlpp::rgba_color(uint8_t(byte(generator)), uint8_t(byte(generator)),
+				uint8_t(byte(generator)));
+		}
+		return colors;
+	};
+	auto from = random_colors(leds);
+	auto to = random_colors(leds);
+	std::vector<vlpp::rgba_color> result(leds);
+	
+	// the largest difference of a channel after the conversion there and back:
+	auto max_error = [&](vlpp::color_space space) {
+		int error = 0;
+		for (std::size_t i = 0; i < leds; ++i) {
+			auto col = vlpp::interpolate(space, from[i], from[i], 0);
+			error = std::max({error, std::abs(col.red - from[i].red),
+				std::abs(col.green - from[i].green), std::abs(col.blue - from[i].blue)});
+		}
+		return error;
+	};
+	
+	std::cout << frames << " frames à " << leds << " LEDs\n";
+	using vlpp::color_space;
+	for (auto space: {color_space::rgb, color_space::hsv, color_space::hsl, color_space::lab,
+			color_space::oklab}) {
+		unsigned checksum = 0;
+		auto start = bench_clock::now();
+		for (std::size_t frame = 0; frame < frames; ++frame) {
+			float t = static_cast<float>(frame) / static_cast<float>(frames);
+			vlpp::interpolate(space, from.data(), to.data(), result.data(), leds, t);
+			checksum += result[frame % leds].red;
+		}
+		auto seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+		std::cout << vlpp::to_string(space) << ": " << static_cast<double>(frames * leds) / seconds / 1e6
+		          << " million LEDs/s, round-trip error " << max_error(space)
+		          << " (checksum " << checksum << ")" << std::endl;
+	}
+	
+	// the vectorized conversion of arrays against the one of single colors:
+	std::vector<vlpp::oklab_color> lab(leds);
+	for (bool arrays: {false, true}) {
+		auto start = bench_clock::now();
+		for (std::size_t frame = 0; frame < frames; ++frame) {
+			if (arrays) {
+				vlpp::to_oklab(from.data(), lab.data(), leds);
+				vlpp::from_oklab(lab.data(), result.data(), leds);
+			}
+			else {
+				for (std::size_t i = 0; i < leds; ++i) {
+					result[i] = vlpp::from_oklab(vlpp::to_oklab(from[i]));
+				}
+			}
+		}
+		auto seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+		std::cout << (arrays ? "oklab arrays:     " : "oklab per color:  ")
+		          << static_cast<double>(frames * leds) / seconds / 1e6 << " million round-trips/s"
+		          << std::endl;
+	}
+	return 0;
+}
+
+int bench_layers(const std::vector<std::string>& args) {
+	std::size_t leds;
+	std::size_t layers;
+	std::size_t frames;
+	double coverage;
+	
+	bpo::options_description desc("layers: compares flattening a layer_stack with compositing "
+		"every LED of every layer one by one");
+	desc.add_options()
+		("help,h", "print this help")
+		("leds,l", bpo::value<std::size_t>(&leds)->default_value(10000), "LEDs per frame")
+		("layers,L", bpo::value<std::size_t>(&layers)->default_value(4),
+		 "number of layers, their modes are over, add, multiply and screen in turn")
+		("frames,n", bpo::value<std::size_t>(&frames)->default_value(500), "number of frames")
+		("coverage,c", bpo::value<double>(&coverage)->default_value(0.25),
+		 "the fraction of the LEDs that every layer draws on in a frame");
+	bpo::variables_map vm;
+	if (!parse_args(args, desc, vm)) {
+		return 0;
+	}
+	if (leds == 0 || leds > vlpp::LED_COUNT || layers == 0 || coverage < 0 || coverage > 1) {
+		throw std::invalid_argument("invalid number of LEDs or layers or invalid coverage");
+	}
+	
+	const vlpp::blend_mode modes[] = {vlpp::blend_mode::over, vlpp::blend_mode::add,
+		vlpp::blend_mode::multiply, vlpp::blend_mode::screen};
+	vlpp::layer_stack stack(leds);
+	for (std::size_t layer = 0; layer < layers; ++layer) {
+		stack.add_layer(modes[layer % 4]);
+	}
+	
+	// every layer draws a window that moves along the LEDs:
+	std::mt19937 generator(42);
+	std::uniform_int_distribution<unsigned> byte(0, UINT8_MAX);
+	std::vector<vlpp::rgba_color> pattern(leds);
+	for (auto& col: pattern) {
+		col = vlpp::rgba_color(uint8_t(byte(generator)), uint8_t(byte(generator)),
+			uint8_t(byte(generator)), uint8_t(byte(generator)));
+	}
+	auto width = static_cast<std::size_t>(coverage * static_cast<double>(leds));
+	std::vector<std::vector<vlpp::rgba_color>> shadow(layers,
+		std::vector<vlpp::rgba_color>(leds, vlpp::rgba_color(0, 0, 0, 0)));
+	auto draw = [&](std::size_t frame) {
+		for (std::size_t layer = 0; layer < layers; ++layer) {
+			auto first = (frame * 7 + layer * leds / layers) % (leds - width + 1);
+			stack.clear(layer);
+			stack.set_leds(layer, static_cast<uint16_t>(first), pattern.data(), width);
+			std::fill(shadow[layer].begin(), shadow[layer].end(), vlpp::rgba_color(0, 0, 0, 0));
+			std::copy(pattern.begin(), pattern.begin() + static_cast<std::ptrdiff_t>(width),
+				shadow[layer].begin() + static_cast<std::ptrdiff_t>(first));
+		}
+	};
+	auto reference = [&](std::vector<vlpp::rgba_color>& frame) {
+		for (std::size_t i = 0; i < leds; ++i) {
+			vlpp::rgba_color col(0, 0, 0);
+			for (std::size_t layer = 0; layer < layers; ++layer) {
+				col = vlpp::composite(modes[layer % 4], col, shadow[layer][i]);
+			}
+			frame[i] = col;
+		}
+	};
+	
+	std::vector<vlpp::rgba_color> frame(leds);
+	std::vector<vlpp::rgba_color> expected(leds);
+	for (std::size_t n = 0; n < 20; ++n) {
+		draw(n);
+		stack.flatten(frame);
+		reference(expected);
+		if (frame != expected) {
+			std::cout << "the layer_stack differs from the reference in frame " << n << std::endl;
+			return 1;
+		}
+	}
+	std::cout << "identical to the reference\n" << frames << " frames à " << leds << " LEDs, "
+	          << layers << " layers with " << width << " LEDs each\n";
+	
+	for (bool flatten: {false, true}) {
+		std::vector<double> times;
+		times.reserve(frames);
+		for (std::size_t n = 0; n < frames; ++n) {
+			draw(n);
+			auto before = bench_clock::now();
+			if (flatten) {
+				stack.flatten(frame);
+			}
+			else {
+				reference(expected);
+			}
+			times.push_back(to_us(bench_clock::now() - before));
+		}
+		print_latencies(flatten ? "flatten()     " : "per LED, AoS  ", times);
+	}
+	return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef BENCHMARKS_HPP
+#define BENCHMARKS_HPP
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Measures how long flush() blocks the render-thread.
+ * @param args the commandline-arguments of the benchmark
+ * @return the exit-code of the program
+ */
+int bench_flush(const std::vector<std::string>& args);
+
+/**
+ * @brief Compares flattening a layer_stack with compositing every LED one by one.
+ * @param args the commandline-arguments of the benchmark
+ * @return the exit-code of the program
+ */
+int bench_layers(const std::vector<std::string>& args);
+
+/**
+ * @brief Compares the bytes per frame of a mostly static scene with and without delta-mode.
+ * @param args the commandline-arguments of the benchmark
+ * @return the exit-code of the program
+ */
+int bench_delta(const std::vector<std::string>& args);
+
+/**
+ * @brief Compares the bytes per frame with and without compaction if LEDs are overwritten.
+ * @param args the commandline-arguments of the benchmark
+ * @return the exit-code of the program
+ */
+int bench_compaction(const std::vector<std::string>& args);
+
+/**
+ * @brief Compares the bytes per frame of fills and chases with one SET_LED per LED.
+ * @param args the commandline-arguments of the benchmark
+ * @return the exit-code of the program
+ */
+int bench_encoding(const std::vector<std::string>& args);
+
+/**
+ * @brief Checks that the noexcept-interface doesn't allocate memory per frame.
+ * @param args the commandline-arguments of the benchmark
+ * @return the exit-code of the program, 1 if there were allocations
+ */
+int bench_realtime(const std::vector<std::string>& args);
+
+/**
+ * @brief Compares the frame-time of a vlpp::cluster_client with sequential clients.
+ * @param args the commandline-arguments of the benchmark
+ * @return the exit-code of the program
+ */
+int bench_cluster(const std::vector<std::string>& args);
+
+/**
+ * @brief Compares the skew between the strobes of servers with different latencies
+ *        and clocks with and without timed strobes.
+ * @param args the commandline-arguments of the benchmark
+ * @return the exit-code of the program
+ */
+int bench_skew(const std::vector<std::string>& args);
+
+/**
+ * @brief Compares many producers on a vlpp::concurrent_client with a shared vlpp::client.
+ * @param args the commandline-arguments of the benchmark
+ * @return the exit-code of the program
+ */
+int bench_concurrent(const std::vector<std::string>& args);
+
+/**
+ * @brief Compares effect-tasks as coroutines on one thread with one thread per task.
+ * @param args the commandline-arguments of the benchmark
+ * @return the exit-code of the program
+ */
+int bench_coroutines(const std::vector<std::string>& args);
+
+/**
+ * @brief Compares the latency from flush() to the arrival of the frame over tcp and udp.
+ * @param args the commandline-arguments of the benchmark
+ * @return the exit-code of the program
+ */
+int bench_latency(const std::vector<std::string>& args);
+
+/**
+ * @brief Compares set_leds() and flush() with submit() for the frames of a video-wall.
+ * @param args the commandline-arguments of the benchmark
+ * @return the exit-code of the program
+ */
+int bench_submit(const std::vector<std::string>& args);
+
+/**
+ * @brief Compares set_led() and flush() with a static_frame for a fixed set of LEDs.
+ * @param args the commandline-arguments of the benchmark
+ * @return the exit-code of the program
+ */
+int bench_static(const std::vector<std::string>& args);
+
+/**
+ * @brief Checks the blend-kernel against its reference and compares the speed of fades.
+ * @param args the commandline-arguments of the benchmark
+ * @return the exit-code of the program
+ */
+int bench_blend(const std::vector<std::string>& args);
+
+/**
+ * @brief Checks the conversions between color-spaces and compares interpolations in them.
+ * @param args the commandline-arguments of the benchmark
+ * @return the exit-code of the program
+ */
+int bench_colorspace(const std::vector<std::string>& args);
+
+/**
+ * @brief Compares easing through a std::function with inlined curves and their tables.
+ * @param args the commandline-arguments of the benchmark
+ * @return the exit-code of the program
+ */
+int bench_easing(const std::vector<std::string>& args);
+
+#endif // BENCHMARKS_HPP
@@ -0,0 +1,134 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "coroutines.hpp"
+
+#include <exception>
+#include <stdexcept>
+// older versions of asio use std::exchange() in C++20 without including it:
+#include <utility>
+
+#include <boost/asio.hpp>
+
+#include "../lib/client.hpp"
+
+#ifdef VLPP_HAS_COROUTINES
+
+namespace {
+
+using effect_clock = std::chrono::steady_clock;
+
+/*
+ * The simplest coroutine-type: it starts right away and cleans up after itself.
+ */
+struct task {
+	struct promise_type {
+		task get_return_object() {
+			return {};
+		}
+		std::suspend_never initial_suspend() noexcept {
+			return {};
+		}
+		std::suspend_never final_suspend() noexcept {
+			return {};
+		}
+		void return_void() {}
+		void unhandled_exception() {
+			std::terminate();
+		}
+	};
+};
+
+/*
+ * Suspends the coroutine until a timer of the io_service expires.
+ */
+struct wait_until {
+	boost::asio::steady_timer& timer;
+	effect_clock::time_point deadline;
+	
+	bool await_ready() const {
+		return effect_clock::now() >= deadline;
+	}
+	
+	void await_suspend(std::coroutine_handle<> coroutine) {
+		timer.expires_at(deadline);
+		timer.async_wait([coroutine](const boost::system::error_code&) {
+			coroutine.resume();
+		});
+	}
+	
+	void await_resume() const {}
+};
+
+task run_effect(boost::asio::io_context& io_service, const effect_load& load, std::size_t index,
+		std::vector<double>& lateness, std::exception_ptr& error) {
+	try {
+		vlpp::client client;
+		co_await client.async_connect(io_service, "127.0.0.1", "sixteen letters.", load.port);
+		boost::asio::steady_timer timer(io_service);
+		std::vector<vlpp::rgba_color> colors(load.leds);
+		auto first = static_cast<uint16_t>(index * load.leds);
+		auto deadline = effect_clock::now();
+		for (std::size_t frame = 0; frame < load.frames; ++frame) {
+			for (std::size_t led = 0; led < colors.size(); ++led) {
+				colors[led] = vlpp::rgba_color(uint8_t(frame), uint8_t(led), uint8_t(index));
+			}
+			client.set_leds(first, colors.data(), colors.size());
+			co_await client.async_flush();
+			lateness.push_back(std::chrono::duration<double, std::micro>(
+				effect_clock::now() - deadline).count());
+			deadline += load.period;
+			co_await wait_until{timer, deadline};
+		}
+	}
+	catch (std::exception&) {
+		error = std::current_exception();
+	}
+}
+
+} // anonymous namespace
+
+bool coroutines_available() {
+	return true;
+}
+
+std::vector<double> run_coroutine_effects(const effect_load& load) {
+	boost::asio::io_context io_service;
+	std::vector<double> lateness;
+	std::exception_ptr error;
+	for (std::size_t i = 0; i < load.tasks; ++i) {
+		run_effect(io_service, load, i, lateness, error);
+	}
+	io_service.run();
+	if (error) {
+		std::rethrow_exception(error);
+	}
+	return lateness;
+}
+
+#else
+
+bool coroutines_available() {
+	return false;
+}
+
+std::vector<double> run_coroutine_effects(const effect_load&) {
+	throw std::logic_error("built without coroutines");
+}
+
+#endif
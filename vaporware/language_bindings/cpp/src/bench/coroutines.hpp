@@ -0,0 +1,55 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COROUTINES_HPP
+#define COROUTINES_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief The workload of the effect-tasks of bench coroutines.
+ *
+ * Every task owns its own client and the LEDs [index * leds, (index + 1) * leds) and
+ * sends one frame per period.
+ */
+struct effect_load {
+	std::size_t tasks;
+	std::size_t frames;
+	uint16_t leds;
+	std::chrono::microseconds period;
+	uint16_t port;
+};
+
+/**
+ * @brief Whether the benchmarks were built with C++20-coroutines.
+ */
+bool coroutines_available();
+
+/**
+ * @brief Runs every task as a coroutine, all of them on one io_service in the calling thread.
+ *
+ * This file is the only one that is compiled as C++20, so that the rest of the
+ * benchmarks proves that the library still works for C++11.
+ * @param load the workload
+ * @return how late every frame was sent after its deadline in µs
+ */
+std::vector<double> run_coroutine_effects(const effect_load& load);
+
+#endif // COROUTINES_HPP
@@ -0,0 +1,70 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <functional>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "benchmarks.hpp"
+
+/*
+ * this program runs the benchmarks of the library against a local server
+ */
+int main(int argc, char** argv) {
+	using std::string;
+	
+	const std::map<string, std::function<int(const std::vector<string>&)>> benchmarks = {
+		{"blend", bench_blend},
+		{"flush", bench_flush},
+		{"delta", bench_delta},
+		{"easing", bench_easing},
+		{"colorspace", bench_colorspace},
+		{"compaction", bench_compaction},
+		{"encoding", bench_encoding},
+		{"concurrent", bench_concurrent},
+		{"coroutines", bench_coroutines},
+		{"cluster", bench_cluster},
+		{"latency", bench_latency},
+		{"layers", bench_layers},
+		{"realtime", bench_realtime},
+		{"skew", bench_skew},
+		{"static", bench_static},
+		{"submit", bench_submit}
+	};
+	
+	if (argc < 2 || benchmarks.find(argv[1]) == benchmarks.end()) {
+		std::cerr << "Usage: " << argv[0] << " <benchmark> [options]\n\nBenchmarks:\n";
+		for (auto& bench: benchmarks) {
+			std::cerr << "\t" << bench.first << "\n";
+		}
+		std::cerr << "\nUse “" << argv[0] << " <benchmark> --help” for the options."
+		          << std::endl;
+		return 1;
+	}
+	
+	try {
+		return benchmarks.at(argv[1])(std::vector<string>(argv + 2, argv + argc));
+	}
+	catch (std::exception& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 2;
+	}
+}
@@ -0,0 +1,279 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sink.hpp"
+
+#include <chrono>
+
+#include "../lib/protocol.hpp"
+#include "../server/decoder.hpp"
+
+using boost::asio::ip::tcp;
+
+enum { READ_SIZE = 16384, RECEIVE_BUFFER_SIZE = 65536 };
+
+class sink::connection: public std::enable_shared_from_this<sink::connection> {
+public:
+	connection(sink& parent): _parent(parent), _socket(parent._io_service),
+		_timer(parent._io_service) {}
+	
+	void read() {
+		auto self = shared_from_this();
+		_socket.async_read_some(boost::asio::buffer(_buffer),
+			[self](const boost::system::error_code& e, std::size_t length) {
+				if (e) {
+					return;
+				}
+				self->_parent._bytes_received += length;
+				if (!self->_parent._bytes_per_second) {
+					self->read();
+					return;
+				}
+				// pretend that processing the data takes some time:
+				self->_timer.expires_from_now(std::chrono::microseconds(
+					length * 1000000 / self->_parent._bytes_per_second));
+				self->_timer.async_wait([self](const boost::system::error_code&) {
+					self->read();
+				});
+			});
+	}
+	
+	tcp::socket& socket() {
+		return _socket;
+	}
+	
+private:
+	sink& _parent;
+	tcp::socket _socket;
+	boost::asio::steady_timer _timer;
+	std::array<char, READ_SIZE> _buffer;
+};
+
+sink::sink(std::size_t bytes_per_second):
+	_bytes_per_second(bytes_per_second),
+	_bytes_received(0),
+	_acceptor(_io_service, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)) {
+	accept();
+	_thread = std::thread([this] {
+		_io_service.run();
+	});
+}
+
+sink::~sink() {
+	_io_service.stop();
+	_thread.join();
+}
+
+uint16_t sink::port() const {
+	return _acceptor.local_endpoint().port();
+}
+
+std::size_t sink::bytes_received() const {
+	return _bytes_received;
+}
+
+void sink::accept() {
+	auto conn = std::make_shared<connection>(*this);
+	_acceptor.async_accept(conn->socket(), [this, conn](const boost::system::error_code& e) {
+		if (e) {
+			return;
+		}
+		if (_bytes_per_second) {
+			// keep the kernel-buffers small, so that the throttling is noticable:
+			conn->socket().set_option(tcp::socket::receive_buffer_size(RECEIVE_BUFFER_SIZE));
+		}
+		conn->read();
+		accept();
+	});
+}
+
+datagram_sink::datagram_sink():
+	_frames_received(0),
+	_socket(_io_service, boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4::loopback(), 0)) {
+	receive();
+	_thread = std::thread([this] {
+		_io_service.run();
+	});
+}
+
+datagram_sink::~datagram_sink() {
+	_io_service.stop();
+	_thread.join();
+}
+
+uint16_t datagram_sink::port() const {
+	return _socket.local_endpoint().port();
+}
+
+std::size_t datagram_sink::frames_received() const {
+	return _frames_received;
+}
+
+void datagram_sink::receive() {
+	_socket.async_receive(boost::asio::buffer(_buffer),
+		[this](const boost::system::error_code& e, std::size_t length) {
+			if (e == boost::asio::error::operation_aborted) {
+				return;
+			}
+			if (!e && length >= vlpp::DATAGRAM_HEADER_SIZE
+					&& (_buffer[vlpp::DATAGRAM_HEADER_SIZE - 1] & vlpp::DATAGRAM_LAST)) {
+				++_frames_received;
+			}
+			receive();
+		});
+}
+
+class strobe_sink::connection: public command_handler,
+		public std::enable_shared_from_this<strobe_sink::connection> {
+public:
+	connection(strobe_sink& parent): _parent(parent), _socket(parent._io_service),
+		_link(parent._io_service), _strobe_timer(parent._io_service) {}
+	
+	void read() {
+		auto self = shared_from_this();
+		_socket.async_read_some(boost::asio::buffer(_buffer),
+			[self](const boost::system::error_code& e, std::size_t length) {
+				if (e) {
+					return;
+				}
+				// the data arrives after the latency of the link:
+				self->_link.expires_from_now(self->_parent._latency);
+				self->_link.async_wait([self, length](const boost::system::error_code&) {
+					self->_pending.insert(self->_pending.end(), self->_buffer.data(),
+						self->_buffer.data() + length);
+					self->process();
+				});
+			});
+	}
+	
+	tcp::socket& socket() {
+		return _socket;
+	}
+	
+	void authenticate(const std::string&) override {}
+	void set_led(uint16_t, const vlpp::rgba_color&) override {}
+	void set_range(uint16_t, uint16_t, const vlpp::rgba_color&) override {}
+	void set_leds(uint16_t, const vlpp::rgba_color*, std::size_t) override {}
+	
+	void strobe() override {
+		_parent.strobed();
+	}
+	
+	void strobe_at(uint64_t time) override {
+		auto when = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(time))
+			- _parent._clock_offset;
+		if (when <= std::chrono::steady_clock::now()) {
+			_parent.strobed();
+			return;
+		}
+		_strobe_scheduled = true;
+		_strobe_timer.expires_at(when);
+		auto self = shared_from_this();
+		_strobe_timer.async_wait([self](const boost::system::error_code&) {
+			self->_parent.strobed();
+			self->_strobe_scheduled = false;
+			self->process();
+		});
+	}
+	
+	void ping(uint64_t client_time) override {
+		auto now = std::chrono::steady_clock::now() + _parent._clock_offset;
+		auto reply = std::make_shared<std::array<char, vlpp::PING_REPLY_SIZE>>();
+		(*reply)[0] = static_cast<char>(vlpp::opcodes::PING);
+		vlpp::write_timestamp(client_time, reply->data() + 1);
+		vlpp::write_timestamp(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			now.time_since_epoch()).count()), reply->data() + 1 + vlpp::TIMESTAMP_SIZE);
+		// the answer takes as long as the ping:
+		auto link = std::make_shared<boost::asio::steady_timer>(_parent._io_service);
+		link->expires_from_now(_parent._latency);
+		auto self = shared_from_this();
+		link->async_wait([self, link, reply](const boost::system::error_code&) {
+			boost::asio::async_write(self->_socket, boost::asio::buffer(*reply),
+				[self, reply](const boost::system::error_code&, std::size_t) {});
+		});
+	}
+	
+private:
+	// decodes like the session of the server:
+	void process() {
+		std::size_t consumed;
+		do {
+			if (_strobe_scheduled) {
+				return;
+			}
+			try {
+				consumed = decode(_pending.data(), _pending.size(), *this);
+			}
+			catch (protocol_error&) {
+				return;
+			}
+			_pending.erase(_pending.begin(), _pending.begin() + static_cast<std::ptrdiff_t>(consumed));
+		} while (consumed);
+		read();
+	}
+	
+	strobe_sink& _parent;
+	tcp::socket _socket;
+	boost::asio::steady_timer _link;
+	boost::asio::steady_timer _strobe_timer;
+	bool _strobe_scheduled = false;
+	std::array<char, READ_SIZE> _buffer;
+	std::vector<char> _pending;
+};
+
+strobe_sink::strobe_sink(std::chrono::nanoseconds clock_offset, std::chrono::microseconds latency):
+	_clock_offset(clock_offset),
+	_latency(latency),
+	_acceptor(_io_service, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)) {
+	accept();
+	_thread = std::thread([this] {
+		_io_service.run();
+	});
+}
+
+strobe_sink::~strobe_sink() {
+	_io_service.stop();
+	_thread.join();
+}
+
+uint16_t strobe_sink::port() const {
+	return _acceptor.local_endpoint().port();
+}
+
+std::vector<std::chrono::steady_clock::time_point> strobe_sink::strobes() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _strobes;
+}
+
+void strobe_sink::strobed() {
+	auto now = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> lock(_mutex);
+	_strobes.push_back(now);
+}
+
+void strobe_sink::accept() {
+	auto conn = std::make_shared<connection>(*this);
+	_acceptor.async_accept(conn->socket(), [this, conn](const boost::system::error_code& e) {
+		if (e) {
+			return;
+		}
+		conn->socket().set_option(tcp::no_delay(true));
+		conn->read();
+		accept();
+	});
+}
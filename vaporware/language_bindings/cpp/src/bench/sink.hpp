@@ -0,0 +1,155 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SINK_HPP
+#define SINK_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+/**
+ * @brief A local tcp-server that reads and discards everything that is sent to it.
+ *
+ * It runs in its own thread and can limit its throughput to simulate a slow
+ * link or an overloaded server.
+ */
+class sink {
+public:
+	/**
+	 * @brief Starts listening on an ephemeral port on the loopback-interface.
+	 * @param bytes_per_second the maximum throughput, 0 means unlimited
+	 */
+	explicit sink(std::size_t bytes_per_second = 0);
+	~sink();
+	
+	sink(const sink&) = delete;
+	sink &operator=(const sink&) = delete;
+	
+	/**
+	 * @brief the port the sink is listening on
+	 */
+	uint16_t port() const;
+	
+	/**
+	 * @brief the total number of bytes received so far
+	 */
+	std::size_t bytes_received() const;
+	
+private:
+	class connection;
+	
+	void accept();
+	
+	std::size_t _bytes_per_second;
+	std::atomic<std::size_t> _bytes_received;
+	boost::asio::io_service _io_service;
+	boost::asio::ip::tcp::acceptor _acceptor;
+	std::thread _thread;
+};
+
+/**
+ * @brief A local udp-server that counts the frames of clients in udp-mode.
+ *
+ * It runs in its own thread; the datagrams are not decoded.
+ */
+class datagram_sink {
+public:
+	/**
+	 * @brief Starts receiving on an ephemeral port on the loopback-interface.
+	 */
+	datagram_sink();
+	~datagram_sink();
+	
+	datagram_sink(const datagram_sink&) = delete;
+	datagram_sink &operator=(const datagram_sink&) = delete;
+	
+	/**
+	 * @brief the port the sink is receiving on
+	 */
+	uint16_t port() const;
+	
+	/**
+	 * @brief the number of datagrams that completed a frame so far
+	 */
+	std::size_t frames_received() const;
+	
+private:
+	void receive();
+	
+	std::atomic<std::size_t> _frames_received;
+	boost::asio::io_service _io_service;
+	boost::asio::ip::udp::socket _socket;
+	std::array<char, 65536> _buffer;
+	std::thread _thread;
+};
+
+/**
+ * @brief A local tcp-server that simulates a remote server and records its strobes.
+ *
+ * It runs in its own thread and decodes the commands like the server. Its monotonic
+ * clock is ahead of the local one by a fixed offset, and everything it receives
+ * and sends is delayed by a fixed latency; a STROBE_AT is executed when its clock
+ * reaches the time.
+ */
+class strobe_sink {
+public:
+	/**
+	 * @brief Starts listening on an ephemeral port on the loopback-interface.
+	 * @param clock_offset the offset of the simulated clock against std::chrono::steady_clock
+	 * @param latency the one-way-latency of the simulated link
+	 */
+	strobe_sink(std::chrono::nanoseconds clock_offset, std::chrono::microseconds latency);
+	~strobe_sink();
+	
+	strobe_sink(const strobe_sink&) = delete;
+	strobe_sink &operator=(const strobe_sink&) = delete;
+	
+	/**
+	 * @brief the port the sink is listening on
+	 */
+	uint16_t port() const;
+	
+	/**
+	 * @brief the local times of all strobes so far
+	 */
+	std::vector<std::chrono::steady_clock::time_point> strobes() const;
+	
+private:
+	class connection;
+	
+	void accept();
+	void strobed();
+	
+	std::chrono::nanoseconds _clock_offset;
+	std::chrono::microseconds _latency;
+	mutable std::mutex _mutex;
+	std::vector<std::chrono::steady_clock::time_point> _strobes;
+	boost::asio::io_service _io_service;
+	boost::asio::ip::tcp::acceptor _acceptor;
+	std::thread _thread;
+};
+
+#endif // SINK_HPP
@@ -3,10 +3,14 @@
 #include <cstdint>
 #include <random>
 #include <chrono>
-#include <mutex>
 
 #include "settings.hpp"
 
+#include "../lib/blend.hpp"
+#include "../lib/color_space.hpp"
+#include "../lib/easing.hpp"
+#include "../lib/frame_scheduler.hpp"
+
 #include <cstdio>
 
 void control_LEDs(const std::vector<uint16_t>& led_list) {
@@ -35,37 +39,61 @@ void control_LEDs(const std::vector<uint16_t>& led_list) {
 	}
 }
 
+namespace {
+
+/*
+ * Fades with an easing-curve that is known at compile time, so it is inlined into the
+ * steps.
+ */
+template<typename Curve>
+void fade_with_curve(const std::vector<uint16_t>& led_list,
+		useconds_t fade_time, const vlpp::rgba_color& old_color,
+		const vlpp::rgba_color& new_color){
+	// the steps are scheduled at absolute times, so sending doesn't slow the fade down:
+	vlpp::frame_scheduler scheduler(1e6 * settings::fade_steps / fade_time);
+	scheduler.run([&](const vlpp::frame_scheduler::frame_info& info){
+		int i = static_cast<int>(info.frame);
+		if(i >= settings::fade_steps){
+			return false;
+		}
+		// all LEDs of the thread have the same color, so it is blended only once:
+		if(settings::space == vlpp::color_space::rgb){
+			set_leds(led_list, vlpp::blend(old_color, new_color,
+				vlpp::easing::weight<Curve>(i, settings::fade_steps)));
+		}
+		else{
+			auto t = Curve::ease(static_cast<double>(i) / settings::fade_steps);
+			set_leds(led_list, vlpp::interpolate(settings::space, old_color, new_color,
+				static_cast<float>(t)));
+		}
+		return !settings::thread_return_flag;
+	});
+}
+
+struct fader {
+	const std::vector<uint16_t>& led_list;
+	useconds_t fade_time;
+	const vlpp::rgba_color& old_color;
+	const vlpp::rgba_color& new_color;
+	
+	template<typename Curve>
+	void operator()(Curve) const {
+		fade_with_curve<Curve>(led_list, fade_time, old_color, new_color);
+	}
+};
+
+} // anonymous namespace
+
 void fade_to(const std::vector<uint16_t>& led_list,
 		useconds_t fade_time, const vlpp::rgba_color& old_color,
 		const vlpp::rgba_color& new_color){
-	useconds_t time_per_step = fade_time / settings::fade_steps;
-	for(int i=0; i < settings::fade_steps; ++i){
-		auto color_shares = settings::color_ratio_function(i, settings::fade_steps);
-		auto p_new = color_shares.first;
-		auto p_old = color_shares.second;
-		vlpp::rgba_color tmp{
-			// i really WANT this narrowing conversion:
-			uint8_t(old_color.red*p_old + new_color.red*p_new),
-			uint8_t(old_color.green*p_old + new_color.green*p_new),
-			uint8_t(old_color.blue*p_old + new_color.blue*p_new),
-			uint8_t(old_color.alpha*p_old + new_color.alpha*p_new)
-		};
-		set_leds(led_list, tmp);
-		usleep(time_per_step);
+	if(fade_time > 0){
+		vlpp::easing::visit(settings::easing, fader{led_list, fade_time, old_color, new_color});
 	}
 	set_leds(led_list, new_color);
 }
 
-std::pair<double, double> get_linear_color_ratio(int current_step, int total_steps){
-	double tmp = static_cast<double>(current_step) / total_steps;
-	return {tmp, 1 - tmp};
-}
-
 void set_leds(const std::vector<uint16_t>& led_list, const vlpp::rgba_color& col){
-	static std::mutex m;
-	std::lock_guard<std::mutex> lock(m);
-	for(auto led: led_list){
-		settings::client.set_led(led, col);
-	}
-	settings::client.flush();
+	// the client sends the changes of all threads with its next frame:
+	settings::client.set_leds(led_list, col);
 }
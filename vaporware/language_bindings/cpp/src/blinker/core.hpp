@@ -27,21 +27,12 @@ void fade_to(const std::vector<uint16_t>& led_list,
 		const vlpp::rgba_color& new_color);
 
 /**
- * @brief Sets some LEDs to a new color in a synchronized way.
+ * @brief Sets some LEDs to a new color; they will be sent with the next frame.
  * @param LEDs a vector that contains the LED-IDs
  * @param col the new color
  */
 void set_leds(const std::vector<uint16_t>& led_list, const vlpp::rgba_color& col);
 
-/**
- * @brief Returns a linear ratio between two colors, based on the ratio 
- * of the current step vs. the total number of steps.
- * @param current_step the current step
- * @param total_steps the total number of steps
- * @return a pair of two ratios where the first one represents the share of the 
- * old color and the second the share of the new color.
- */
-std::pair<double, double> get_linear_color_ratio(int current_step, int total_steps);
 
 
 
@@ -21,6 +21,7 @@
 #include <stdexcept>
 #include <thread>
 #include <cassert>
+#include <chrono>
 
 #include <unistd.h>
 
@@ -59,7 +60,9 @@ int main(int argc, char** argv) {
 		}
 		
 		led_list = str_to_ids(settings::led_string);
-		settings::client = vlpp::client(settings::server, settings::token, settings::port);
+		settings::client = vlpp::concurrent_client(settings::server, settings::token, settings::port,
+			std::chrono::microseconds(1000000 / settings::fps));
+		settings::client.set_resilient(settings::reconnect);
 		std::vector<std::thread> threads;
 		if (settings::synced) {
 			threads.emplace_back(control_LEDs, led_list);
@@ -1,6 +1,7 @@
 #include "settings.hpp"
 
 #include <iostream>
+#include <stdexcept>
 #include <boost/program_options.hpp>
 
 #include "core.hpp"
@@ -19,9 +20,12 @@ useconds_t settings::max_sleep_time = 100000;
 useconds_t settings::min_fade_time  = 0;
 useconds_t settings::max_fade_time  = 100000;
 std::vector<vlpp::rgba_color> settings::colorset;
-vlpp::client settings::client;
+unsigned settings::fps = 100;
+bool settings::reconnect = false;
+vlpp::concurrent_client settings::client;
 std::atomic<bool> settings::thread_return_flag(false);
-std::function<std::pair<double,double>(int, int)> settings::color_ratio_function = get_linear_color_ratio;
+vlpp::easing::curve settings::easing = vlpp::easing::curve::linear;
+vlpp::color_space settings::space = vlpp::color_space::rgb;
 
 
 
@@ -29,11 +33,14 @@ return_action set_options(int argc, char** argv) {
 	using boost::program_options::value;
 	
 	std::string tmp_colorset_str;
+	std::string tmp_easing_str;
+	std::string tmp_space_str;
 	
 	boost::program_options::options_description desc;
 	desc.add_options()
 		("help,h", "print this help")
 		("sync,y", "makes the LEDs blink asynchronus.")
+		("reconnect,r", "keep blinking and reconnect if the connection is lost")
 		("token,t", value<std::string>(&settings::token), "sets the authentication-token")
 		("server,s", value<std::string>(&settings::server), "sets the servername")
 		("port,p", value<uint16_t>(&settings::port)->default_value(vlpp::client::DEFAULT_PORT),
@@ -46,7 +53,12 @@ return_action set_options(int argc, char** argv) {
 		("colors,c", value<std::string>(&tmp_colorset_str), "sets the used colorset")
 		("min-fade", value<useconds_t>(&settings::min_fade_time), "changes the minimum fade time")
 		("max-fade,f", value<useconds_t>(&settings::max_fade_time), "changes the maximum fade time")
-		("fade-steps,F", value<int>(&settings::fade_steps), "sets the number of steps for fading");
+		("fade-steps,F", value<int>(&settings::fade_steps), "sets the number of steps for fading")
+		("easing,e", value<std::string>(&tmp_easing_str)->default_value("linear"),
+		 "sets the easing-curve of the fades: linear, cubic, sine, exponential or perceptual")
+		("space", value<std::string>(&tmp_space_str)->default_value("rgb"),
+		 "sets the color-space of the fades: rgb, hsv, hsl, lab or oklab")
+		("fps", value<unsigned>(&settings::fps), "sets the number of frames per second");
 
 	boost::program_options::variables_map vm;
 	boost::program_options::store(boost::program_options::parse_command_line(argc, argv, desc), vm);
@@ -62,9 +74,26 @@ return_action set_options(int argc, char** argv) {
 		return return_action::exit_failed;
 	}
 	
+	try{
+		settings::easing = vlpp::easing::curve_from_string(tmp_easing_str);
+		settings::space = vlpp::color_space_from_string(tmp_space_str);
+	}
+	catch(std::invalid_argument& e){
+		std::cerr << "Error: " << e.what() << std::endl;
+		return return_action::exit_failed;
+	}
+	
+	if(settings::fps < 1){
+		std::cerr << "Error: There must be one frame per second at minimum." << std::endl;
+		return return_action::exit_failed;
+	}
+	
 	if(vm.count("sync")){
 		settings::synced = true;
 	}
+	if(vm.count("reconnect")){
+		settings::reconnect = true;
+	}
 	settings::colorset = str_to_cols(tmp_colorset_str);
 	if(settings::colorset.size() <= 0){
 		settings::colorset = REAL_COLORS;
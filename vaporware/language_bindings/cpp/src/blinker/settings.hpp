@@ -4,10 +4,11 @@
 #include <cstdint>
 #include <unistd.h>
 #include <atomic>
-#include <functional>
 #include <utility>
 
-#include "../lib/client.hpp"
+#include "../lib/color_space.hpp"
+#include "../lib/concurrent_client.hpp"
+#include "../lib/easing.hpp"
 #include "../util/colors.hpp"
 
 /**
@@ -69,10 +70,20 @@ struct settings{
 	 */
 	static std::vector<vlpp::rgba_color> colorset;
 	
+	/**
+	 * @brief The number of frames per second that are sent to the server.
+	 */
+	static unsigned fps;
+	
+	/**
+	 * @brief Whether the client reconnects if the connection is lost.
+	 */
+	static bool reconnect;
+	
 	/**
 	 * @brief The actual client that holds the connection to the server.
 	 */
-	static vlpp::client client;
+	static vlpp::concurrent_client client;
 	
 	/**
 	 * @brief A flag that tells the controll-threads to return, if set to true.
@@ -80,9 +91,14 @@ struct settings{
 	static std::atomic<bool> thread_return_flag;
 	
 	/**
-	 * @brief The function that will be used to calculate the ratio between two colors when fading.
+	 * @brief The easing-curve that will be used when fading between two colors.
+	 */
+	static vlpp::easing::curve easing;
+	
+	/**
+	 * @brief The color-space in which the colors are interpolated when fading.
 	 */
-	static std::function<std::pair<double,double>(int, int)> color_ratio_function;
+	static vlpp::color_space space;
 };
 
 /**
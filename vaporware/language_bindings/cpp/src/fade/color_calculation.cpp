@@ -1,5 +1,6 @@
 #include "color_calculation.hpp"
 
+#include <array>
 #include <cmath>
 
 constexpr double SIN_FACTOR = 2 * M_PI;
@@ -13,3 +14,72 @@ vlpp::rgba_color calc_deg_color(double degree){
 	returncolor.blue = uint8_t( UINT8_MAX * (sin(SIN_FACTOR * degree + B_CHANNEL_SHIFT ) + 1)/2 );
 	return returncolor;
 }
+
+// the wheel has 4 * 2^QUARTER_BITS positions, selected by the highest bits of the phase:
+constexpr unsigned QUARTER_BITS = 10;
+constexpr uint32_t QUARTER = 1u << QUARTER_BITS;
+constexpr unsigned POSITION_SHIFT = 32 - QUARTER_BITS - 2;
+constexpr uint32_t GREEN_SHIFT = 0x55555555u;
+constexpr uint32_t BLUE_SHIFT = 0xaaaaaaabu;
+
+/*
+ * sin(x) for the first quarter of a turn in 1/32768, with the end-point, so that the
+ * falling quarters can read it backwards
+ */
+static const std::array<uint16_t, QUARTER + 1>& quarter_wave() {
+	static const std::array<uint16_t, QUARTER + 1> table = [] {
+		std::array<uint16_t, QUARTER + 1> result;
+		for (uint32_t i = 0; i <= QUARTER; ++i) {
+			result[i] = static_cast<uint16_t>(std::lround(32768 * sin(M_PI / 2 * i / QUARTER)));
+		}
+		return result;
+	}();
+	return table;
+}
+
+/*
+ * (sin + 1) / 2 scaled to a channel, as in calc_deg_color()
+ */
+static uint8_t channel(const std::array<uint16_t, QUARTER + 1>& table, uint32_t phase) {
+	uint32_t position = phase >> POSITION_SHIFT;
+	uint32_t offset = position & (QUARTER - 1);
+	int32_t value = (position & QUARTER) ? table[QUARTER - offset] : table[offset];
+	if (position & (2 * QUARTER)) {
+		value = -value;
+	}
+	return static_cast<uint8_t>((UINT8_MAX * (32768 + value)) >> 16);
+}
+
+color_wheel::color_wheel(uint32_t phase, uint32_t increment):
+	_phase(phase), _increment(increment)
+{}
+
+uint32_t color_wheel::to_phase(double turns) {
+	double fraction = turns - std::floor(turns);
+	return static_cast<uint32_t>(static_cast<uint64_t>(std::llround(fraction * 4294967296.0)));
+}
+
+vlpp::rgba_color color_wheel::color_at(uint32_t phase) {
+	auto& table = quarter_wave();
+	return vlpp::rgba_color(channel(table, phase), channel(table, phase + GREEN_SHIFT),
+		channel(table, phase + BLUE_SHIFT));
+}
+
+vlpp::rgba_color color_wheel::next() {
+	auto result = color_at(_phase);
+	_phase += _increment;
+	return result;
+}
+
+void color_wheel::fill(vlpp::rgba_color* colors, std::size_t count, uint32_t offset,
+		uint8_t alpha) const {
+	auto& table = quarter_wave();
+	uint32_t phase = _phase;
+	for (std::size_t i = 0; i < count; ++i, phase += offset) {
+		// the constructor of rgba_color isn't inline, the members are:
+		colors[i].red = channel(table, phase);
+		colors[i].green = channel(table, phase + GREEN_SHIFT);
+		colors[i].blue = channel(table, phase + BLUE_SHIFT);
+		colors[i].alpha = alpha;
+	}
+}
@@ -1,8 +1,65 @@
 #ifndef COLOR_CALCULATION_HPP
 #define COLOR_CALCULATION_HPP
 
+#include <cstddef>
+#include <cstdint>
+
 #include "../lib/rgba_color.hpp"
 
 vlpp::rgba_color calc_deg_color(double degree);
 
+/**
+ * @brief A color-wheel that yields the same colors as calc_deg_color() without libm.
+ *
+ * The position on the wheel is a 32-bit phase, where 2^32 is one turn, so it wraps
+ * around by itself. Every channel is a sine that is read from a table of a quarter
+ * wave; green and blue follow red by a third and two thirds of a turn.
+ */
+class color_wheel {
+public:
+	/**
+	 * @brief Creates a wheel.
+	 * @param phase the initial phase
+	 * @param increment the phase that next() advances the wheel by
+	 */
+	explicit color_wheel(uint32_t phase = 0, uint32_t increment = 0);
+	
+	/**
+	 * @brief Converts a fraction of a turn into a phase, e.g. 0.5 into 2^31.
+	 */
+	static uint32_t to_phase(double turns);
+	
+	/**
+	 * @brief the color at a phase
+	 */
+	static vlpp::rgba_color color_at(uint32_t phase);
+	
+	/**
+	 * @brief Returns the color at the current phase and advances the wheel.
+	 */
+	vlpp::rgba_color next();
+	
+	/**
+	 * @brief Writes the colors of a rainbow that starts at the current phase.
+	 * @param colors the colors, the one of LED i is the color at phase + i*offset
+	 * @param count the number of colors
+	 * @param offset the phase between two neighbouring LEDs
+	 * @param alpha the alpha-value of all colors
+	 */
+	void fill(vlpp::rgba_color* colors, std::size_t count, uint32_t offset,
+		uint8_t alpha = UINT8_MAX) const;
+	
+	uint32_t phase() const {
+		return _phase;
+	}
+	
+	void set_phase(uint32_t phase) {
+		_phase = phase;
+	}
+	
+private:
+	uint32_t _phase;
+	uint32_t _increment;
+};
+
 #endif // COLOR_CALCULATION_HPP
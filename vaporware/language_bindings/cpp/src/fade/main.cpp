@@ -22,6 +22,9 @@
 #include <map>
 #include <cmath>
 #include <cctype>
+#include <algorithm>
+#include <memory>
+#include <chrono>
 
 #include <unistd.h>
 
@@ -29,11 +32,97 @@
 #include <boost/program_options.hpp>
 
 #include "../lib/client.hpp"
+#include "../lib/cluster_client.hpp"
+#include "../lib/frame_scheduler.hpp"
+#include "../lib/trace.hpp"
 #include "../util/ids.hpp"
+#include "../util/signalhandling.hpp"
 
 #include "color_calculation.hpp"
 
 
+/*
+ * the phase of the color-wheel in a frame; it depends on the frame-number, so that
+ * missed frames don't slow the fade down
+ */
+static uint32_t frame_phase(std::size_t frame) {
+	return static_cast<uint32_t>(static_cast<uint16_t>((frame + 1) * (UINT8_MAX/4))) << 16;
+}
+
+/*
+ * parses a shard like “0-99=bridge1:7534”
+ */
+static vlpp::cluster_client::shard str_to_shard(const std::string& str) {
+	auto dash = str.find('-');
+	auto equals = str.find('=');
+	if (dash == std::string::npos || equals == std::string::npos || equals < dash) {
+		throw std::invalid_argument("invalid shard: “" + str + "”");
+	}
+	vlpp::cluster_client::shard result;
+	result.first = static_cast<uint16_t>(std::stoul(str.substr(0, dash)));
+	result.last = static_cast<uint16_t>(std::stoul(str.substr(dash + 1, equals - dash - 1)));
+	result.server = str.substr(equals + 1);
+	result.port = vlpp::client::DEFAULT_PORT;
+	auto colon = result.server.rfind(':');
+	if (colon != std::string::npos && result.server.compare(0, 5, "unix:") != 0) {
+		result.port = static_cast<uint16_t>(std::stoul(result.server.substr(colon + 1)));
+		result.server.erase(colon);
+	}
+	return result;
+}
+
+/*
+ * sends either one color for all LEDs or, if there are colors, one color per LED
+ */
+template<typename Client>
+static void send_frame(Client& client, const std::vector<uint16_t>& LEDs,
+		const vlpp::rgba_color& col, const std::vector<vlpp::rgba_color>& colors,
+		bool consecutive) {
+	if (colors.empty()) {
+		client.set_leds(LEDs, col);
+	}
+	else if (consecutive) {
+		client.set_leds(LEDs.front(), colors.data(), colors.size());
+	}
+	else {
+		for (std::size_t i = 0; i < LEDs.size(); ++i) {
+			client.set_led(LEDs[i], colors[i]);
+		}
+	}
+	client.flush();
+}
+
+/*
+ * compares calc_deg_color() with the color-wheel for a moving rainbow over some LEDs
+ */
+static void run_bench(std::size_t led_count, std::size_t frames, uint32_t offset) {
+	using bench_clock = std::chrono::steady_clock;
+	std::vector<vlpp::rgba_color> colors(led_count);
+	unsigned checksum = 0;
+	auto start = bench_clock::now();
+	for (std::size_t frame = 0; frame < frames; ++frame) {
+		uint32_t phase = frame_phase(frame);
+		for (std::size_t i = 0; i < led_count; ++i) {
+			colors[i] = calc_deg_color(static_cast<uint32_t>(phase + i * offset) / 4294967296.0);
+		}
+		checksum += colors[frame % led_count].red;
+	}
+	auto libm = std::chrono::duration<double, std::micro>(bench_clock::now() - start).count();
+	std::cout << "calc_deg_color(): " << libm / frames << "µs per frame (checksum " << checksum
+	          << ")" << std::endl;
+	
+	checksum = 0;
+	start = bench_clock::now();
+	for (std::size_t frame = 0; frame < frames; ++frame) {
+		color_wheel(frame_phase(frame)).fill(colors.data(), led_count, offset);
+		checksum += colors[frame % led_count].red;
+	}
+	auto wheel = std::chrono::duration<double, std::micro>(bench_clock::now() - start).count();
+	std::cout << "color_wheel:      " << wheel / frames << "µs per frame (checksum " << checksum
+	          << "), " << static_cast<double>(led_count * frames) / wheel << " million LEDs/s"
+	          << std::endl;
+}
+
 /*
  * this program will just fade through most colors
  */
@@ -48,21 +137,38 @@ int main(int argc, char**argv) {
 	std::vector<uint16_t> LEDs;
 	uint8_t alpha;
 	double timestep;
+	double offset_turns;
+	std::size_t bench_frames;
+	std::string trace_file;
+	std::vector<std::string> shard_strings;
 	
 	try{
 		bpo::options_description desc;
 		desc.add_options()
 				("help,h", "print this help")
-				//("verbose,v", "be verbose")
+				("verbose,v", "print the achieved framerate and jitter every second")
+				("reconnect,r", "keep running and reconnect if the connection is lost")
 				("token,t", bpo::value<std::string>(&token), "sets the authentication-token")
 				("server,s", bpo::value<std::string>(&server), "sets the servername")
+				("shard", bpo::value<std::vector<std::string>>(&shard_strings)->composing(),
+				 "sends the LEDs <first>-<last> to <server>[:<port>], e.g. “0-99=bridge1:7534”; "
+				 "give this once per server instead of --server and --port")
 				("port, p", bpo::value<uint16_t>(&port)->default_value(vlpp::client::DEFAULT_PORT),
 				 "sets the server-port")
 				("leds,l", bpo::value<std::string>(&LED_string), "sets the number of leds")
 				("alpha,a", bpo::value<uint8_t>(&alpha)->default_value(UINT8_MAX), 
 				 "sets the alpha-channel")
 				("timestep,T", bpo::value<double>(&timestep)->default_value(0.1),
-				 "sets the time between lightchanges");
+				 "sets the time between lightchanges")
+				("offset,o", bpo::value<double>(&offset_turns)->default_value(0),
+				 "shifts the color of every LED by this fraction of the color-wheel against "
+				 "the previous one, e.g. 0.01 for a moving rainbow")
+				("bench", bpo::value<std::size_t>(&bench_frames),
+				 "computes this many frames for the LEDs without a server, once with libm "
+				 "and once with the color-wheel, and prints the time per frame")
+				("trace", bpo::value<std::string>(&trace_file),
+				 "writes a chrome-trace of the frames into this file on exit "
+				 "(the library must be built with BUILD_TRACING)");
 		
 		bpo::variables_map vm;
 		bpo::store(bpo::parse_command_line(argc, argv, desc) ,vm);
@@ -78,23 +184,73 @@ int main(int argc, char**argv) {
 				"IDs of at least one LED." << std::endl;
 			return 1;
 		}
+		uint32_t offset = color_wheel::to_phase(offset_turns);
+		if (vm.count("bench")) {
+			run_bench(LEDs.size(), std::max<std::size_t>(bench_frames, 1), offset);
+			return 0;
+		}
 		
-		vlpp::client client(server, token, port);
-		
-		uint16_t color_degree_counter = 0;
-		double color_degree;
-		while(true){
-			color_degree_counter += UINT8_MAX/4;
-			color_degree = static_cast<double>(color_degree_counter) / UINT16_MAX;
-			vlpp::rgba_color tmp = calc_deg_color(color_degree);
-			//std::cout << tmp << std::endl;
-			tmp.alpha = alpha;
-			for(auto id: LEDs){ 
-				client.set_led(id,tmp);
+		// a rig with several servers uses a cluster-client instead:
+		std::unique_ptr<vlpp::client> client;
+		std::unique_ptr<vlpp::cluster_client> cluster;
+		if (shard_strings.empty()) {
+			client.reset(new vlpp::client(server, token, port));
+			client->set_resilient(vm.count("reconnect"));
+		}
+		else {
+			std::vector<vlpp::cluster_client::shard> shards;
+			for (auto& str: shard_strings) {
+				shards.push_back(str_to_shard(str));
 			}
-			client.flush();
-			usleep( static_cast<useconds_t>((1000000*timestep)));
+			cluster.reset(new vlpp::cluster_client(shards, token));
+			cluster->set_resilient(vm.count("reconnect"));
+		}
+		if (!trace_file.empty()) {
+			vlpp::trace::set_thread_name("fade");
+			vlpp::trace::dump_at_exit(trace_file);
 		}
+		// stop with the next frame, so that the trace is written:
+		signalhandling::init();
+		
+		// with an offset every LED gets its own color:
+		std::vector<vlpp::rgba_color> colors(offset ? LEDs.size() : 0);
+		bool consecutive = LEDs.back() - LEDs.front() + 1u == LEDs.size()
+			&& std::is_sorted(LEDs.begin(), LEDs.end());
+		
+		vlpp::frame_scheduler scheduler(1 / timestep);
+		bool verbose = vm.count("verbose");
+		auto stats_interval = static_cast<std::size_t>(std::max(1.0, 1 / timestep));
+		scheduler.run([&](const vlpp::frame_scheduler::frame_info& info) {
+			if (signalhandling::get_last_signal()) {
+				return false;
+			}
+			color_wheel wheel(frame_phase(info.frame));
+			vlpp::rgba_color tmp;
+			{
+				VLPP_TRACE_SCOPE("render");
+				if (colors.empty()) {
+					tmp = wheel.color_at(wheel.phase());
+					tmp.alpha = alpha;
+				}
+				else {
+					wheel.fill(colors.data(), colors.size(), offset, alpha);
+				}
+			}
+			if (cluster) {
+				send_frame(*cluster, LEDs, tmp, colors, consecutive);
+			}
+			else {
+				send_frame(*client, LEDs, tmp, colors, consecutive);
+			}
+			if (verbose && (info.frame + 1) % stats_interval == 0) {
+				auto stats = scheduler.stats();
+				std::cout << "fps: " << stats.fps << ", missed: " << stats.missed
+				          << ", jitter: " << stats.mean_jitter << "µs (±"
+				          << stats.jitter_deviation << "µs, max " << stats.max_jitter
+				          << "µs)" << std::endl;
+			}
+			return true;
+		});
 	}
 	catch(std::exception& e){
 		std::cerr << "Error: " << e.what() << std::endl;
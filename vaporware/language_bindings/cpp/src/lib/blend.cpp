@@ -0,0 +1,186 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "blend.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+// the AVX2-kernel is compiled for its own target and only used if the cpu supports it:
+#include <immintrin.h>
+#define VLPP_BLEND_AVX2
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static_assert(sizeof(vlpp::rgba_color) == 4, "the kernels expect four packed bytes per color");
+
+namespace {
+
+using vlpp::rgba_color;
+using vlpp::BLEND_ONE;
+
+using blend_function = void (*)(const rgba_color*, const rgba_color*, rgba_color*,
+	std::size_t, uint16_t);
+
+struct kernel {
+	blend_function function;
+	const char* name;
+};
+
+uint8_t blend_channel(unsigned from, unsigned to, unsigned weight) {
+	return static_cast<uint8_t>((from * (BLEND_ONE - weight) + to * weight + 128) >> 8);
+}
+
+/*
+ * Blends the colors from first on one by one; the vectorized kernels use this for
+ * the rest of the arrays that doesn't fill a whole register.
+ */
+void blend_scalar(const rgba_color* from, const rgba_color* to, rgba_color* result,
+		std::size_t count, uint16_t weight, std::size_t first = 0) {
+	for (std::size_t i = first; i < count; ++i) {
+		result[i] = vlpp::blend(from[i], to[i], weight);
+	}
+}
+
+#if !defined(__SSE2__) && !defined(__ARM_NEON)
+void blend_scalar_kernel(const rgba_color* from, const rgba_color* to, rgba_color* result,
+		std::size_t count, uint16_t weight) {
+	blend_scalar(from, to, result, count, weight);
+}
+#endif
+
+// All vector-kernels compute in unsigned 16-bit lanes: from*(256-w) + to*w + 128 is
+// at most 255*256 + 128, so nothing overflows and the shift by eight is exact.
+
+#if defined(__SSE2__)
+void blend_sse2(const rgba_color* from, const rgba_color* to, rgba_color* result,
+		std::size_t count, uint16_t weight) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i to_share = _mm_set1_epi16(static_cast<short>(weight));
+	const __m128i from_share = _mm_set1_epi16(static_cast<short>(BLEND_ONE - weight));
+	const __m128i half = _mm_set1_epi16(128);
+	std::size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + i));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(to + i));
+		__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), from_share),
+			_mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), to_share));
+		__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), from_share),
+			_mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), to_share));
+		lo = _mm_srli_epi16(_mm_add_epi16(lo, half), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(hi, half), 8);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(result + i), _mm_packus_epi16(lo, hi));
+	}
+	blend_scalar(from, to, result, count, weight, i);
+}
+#endif
+
+#if defined(VLPP_BLEND_AVX2)
+__attribute__((target("avx2")))
+void blend_avx2(const rgba_color* from, const rgba_color* to, rgba_color* result,
+		std::size_t count, uint16_t weight) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i to_share = _mm256_set1_epi16(static_cast<short>(weight));
+	const __m256i from_share = _mm256_set1_epi16(static_cast<short>(BLEND_ONE - weight));
+	const __m256i half = _mm256_set1_epi16(128);
+	std::size_t i = 0;
+	// unpacking and packing both work within the 128-bit lanes, so the order is kept:
+	for (; i + 8 <= count; i += 8) {
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from + i));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(to + i));
+		__m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(a, zero), from_share),
+			_mm256_mullo_epi16(_mm256_unpacklo_epi8(b, zero), to_share));
+		__m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(a, zero), from_share),
+			_mm256_mullo_epi16(_mm256_unpackhi_epi8(b, zero), to_share));
+		lo = _mm256_srli_epi16(_mm256_add_epi16(lo, half), 8);
+		hi = _mm256_srli_epi16(_mm256_add_epi16(hi, half), 8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(result + i), _mm256_packus_epi16(lo, hi));
+	}
+	blend_scalar(from, to, result, count, weight, i);
+}
+#endif
+
+#if defined(__ARM_NEON)
+void blend_neon(const rgba_color* from, const rgba_color* to, rgba_color* result,
+		std::size_t count, uint16_t weight) {
+	const uint16x8_t to_share = vdupq_n_u16(weight);
+	const uint16x8_t from_share = vdupq_n_u16(static_cast<uint16_t>(BLEND_ONE - weight));
+	std::size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		uint8x16_t a = vld1q_u8(reinterpret_cast<const uint8_t*>(from + i));
+		uint8x16_t b = vld1q_u8(reinterpret_cast<const uint8_t*>(to + i));
+		uint16x8_t lo = vmlaq_u16(vmulq_u16(vmovl_u8(vget_low_u8(a)), from_share),
+			vmovl_u8(vget_low_u8(b)), to_share);
+		uint16x8_t hi = vmlaq_u16(vmulq_u16(vmovl_u8(vget_high_u8(a)), from_share),
+			vmovl_u8(vget_high_u8(b)), to_share);
+		// the rounding shift adds the 128:
+		vst1q_u8(reinterpret_cast<uint8_t*>(result + i),
+			vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+	}
+	blend_scalar(from, to, result, count, weight, i);
+}
+#endif
+
+kernel select_kernel() {
+#if defined(VLPP_BLEND_AVX2)
+	if (__builtin_cpu_supports("avx2")) {
+		return {blend_avx2, "avx2"};
+	}
+#endif
+#if defined(__SSE2__)
+	return {blend_sse2, "sse2"};
+#elif defined(__ARM_NEON)
+	return {blend_neon, "neon"};
+#else
+	return {blend_scalar_kernel, "scalar"};
+#endif
+}
+
+const kernel& active_kernel() {
+	static const kernel selected = select_kernel();
+	return selected;
+}
+
+} // anonymous namespace
+
+uint16_t vlpp::blend_weight(double share) {
+	return static_cast<uint16_t>(std::lround(std::min(1.0, std::max(0.0, share)) * BLEND_ONE));
+}
+
+vlpp::rgba_color vlpp::blend(const rgba_color& from, const rgba_color& to, uint16_t weight) {
+	weight = std::min(weight, BLEND_ONE);
+	return rgba_color(
+		blend_channel(from.red, to.red, weight),
+		blend_channel(from.green, to.green, weight),
+		blend_channel(from.blue, to.blue, weight),
+		blend_channel(from.alpha, to.alpha, weight));
+}
+
+void vlpp::blend(const rgba_color* from, const rgba_color* to, rgba_color* result,
+		std::size_t count, uint16_t weight) {
+	active_kernel().function(from, to, result, count, std::min(weight, BLEND_ONE));
+}
+
+const char* vlpp::blend_kernel() {
+	return active_kernel().name;
+}
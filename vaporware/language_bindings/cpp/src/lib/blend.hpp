@@ -0,0 +1,78 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BLEND_HPP
+#define BLEND_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rgba_color.hpp"
+
+namespace vlpp {
+
+/**
+ * @brief the blend-weight that selects the second color completely
+ *
+ * Weights are fixed-point numbers with eight fractional bits (Q8.8), so the shares of
+ * two blended colors are weight/256 and (256-weight)/256.
+ */
+const uint16_t BLEND_ONE = 256;
+
+/**
+ * @brief Converts the share of the second color into a blend-weight.
+ * @param share the share, it is clamped to [0, 1]
+ * @return the nearest weight in [0, BLEND_ONE]
+ */
+uint16_t blend_weight(double share);
+
+/**
+ * @brief Blends two colors; this is the reference for all vectorized kernels.
+ *
+ * Every channel, including alpha, becomes (from*(256-weight) + to*weight + 128) / 256,
+ * rounded down.
+ *
+ * @param from the color at weight 0
+ * @param to the color at weight BLEND_ONE
+ * @param weight the share of to, at most BLEND_ONE
+ * @return the blended color
+ */
+rgba_color blend(const rgba_color& from, const rgba_color& to, uint16_t weight);
+
+/**
+ * @brief Blends two arrays of colors with the same weight.
+ *
+ * The result is exactly the one of blend() for every single color, but the colors are
+ * processed with SSE2, AVX2 or NEON if the cpu supports them.
+ *
+ * @param from the colors at weight 0
+ * @param to the colors at weight BLEND_ONE
+ * @param result the blended colors; this may be from or to, but no other overlapping array
+ * @param count the number of colors in each array
+ * @param weight the share of to, at most BLEND_ONE
+ */
+void blend(const rgba_color* from, const rgba_color* to, rgba_color* result,
+		std::size_t count, uint16_t weight);
+
+/**
+ * @brief the name of the kernel that blend() uses for arrays on this cpu, e.g. “avx2”
+ */
+const char* blend_kernel();
+
+} // namespace vlpp
+
+#endif // BLEND_HPP
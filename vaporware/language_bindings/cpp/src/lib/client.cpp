@@ -17,38 +17,301 @@
 
 
 #include "client.hpp"
+#include "protocol.hpp"
+#include "trace.hpp"
 
 #include <array>
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <chrono>
+#include <system_error>
+#include <type_traits>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include <boost/asio.hpp>
 
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
 using boost::asio::io_service;
 using boost::asio::ip::tcp;
+using boost::asio::ip::udp;
+using boost::asio::generic::stream_protocol;
+
+using vlpp::opcodes;
+using vlpp::TOKEN_SIZE;
+using vlpp::LED_COUNT;
+using vlpp::DATAGRAM_SIZE;
+using vlpp::DATAGRAM_HEADER_SIZE;
+
+// the colors are sent exactly as they are layed out in memory:
+static_assert(sizeof(vlpp::rgba_color) == 4 && std::is_standard_layout<vlpp::rgba_color>::value,
+	"rgba_color must be a packed RGBA-quadruple");
 
 
 //pimpl-class (private members of client):
-class vlpp::client::client_impl {
+class vlpp::client::client_impl: public std::enable_shared_from_this<client_impl> {
 	public:
 		client_impl(const std::string& servername, const std::string& token, uint16_t port);
+		explicit client_impl(io_service& event_loop);
+		~client_impl();
+		void async_connect(const std::string& servername, const std::string& token, uint16_t port,
+			completion_callback callback);
 		void authenticate(const std::string& token);
 		void set_led(uint16_t led, rgba_color col);
+		void set_led_range(uint16_t first, uint16_t last, rgba_color col);
+		void set_leds(uint16_t first, const rgba_color* colors, std::size_t count);
 		void flush();
+		void flush_at(std::chrono::steady_clock::time_point when);
+		void async_flush(completion_callback callback);
+		clock_estimate sync_clock(unsigned samples);
+		void send();
+		void submit(const frame_view& frame);
+		void submit_set_leds(const char* commands, std::size_t count);
+		void set_async(bool async, flush_callback callback);
+		void set_delta_mode(bool delta);
+		void set_compaction(bool compact);
+		void invalidate();
+		void set_resilient(bool resilient);
+		bool connected();
+		void set_watermark(std::size_t bytes);
+		void set_realtime(bool realtime, unsigned cpu);
+		client_stats stats() const;
+		std::vector<char>& access_buffer() {
+			// the caller may change the buffer, so its last record mustn't be extended:
+			_open_record = NO_RECORD;
+			return cmd_buffer;
+		}
 		io_service _io_service;
-		tcp::socket _socket;
+		// the io_service of the sockets, _io_service unless async_connect() was used:
+		io_service& _event_loop;
+		stream_protocol::socket _socket;
 		std::vector<char> cmd_buffer;
+		
+	private:
+		bool external_loop() const {
+			return &_event_loop != &_io_service;
+		}
+		void connect_next(std::size_t index, const std::string& servername,
+			completion_callback callback);
+		void continue_flush();
+		void finish_flush();
+		void flush_completed(std::exception_ptr error);
+		void resolve_tcp(const std::string& servername, uint16_t port);
+		void connect_udp(const std::string& servername, uint16_t port);
+		static void send_token(stream_protocol::socket& socket, const std::string& token,
+			boost::system::error_code& e);
+		void flush_frame(const char* strobe, std::size_t size);
+		void send_frame(const char* strobe, std::size_t size);
+		void begin_submit();
+		void finish_submit(std::chrono::steady_clock::time_point start, std::size_t records);
+		clock_estimate ping();
+		void write_buffer(bool end_of_frame);
+		void drain();
+		void append(const char* data, std::size_t size);
+		// empties cmd_buffer; there is no record to extend afterwards:
+		void clear_commands() {
+			cmd_buffer.clear();
+			_open_record = NO_RECORD;
+		}
+		void start_monitor();
+		void stop_monitor();
+		void monitor();
+		void wait_for_hangup();
+		bool try_reconnect(stream_protocol::socket& socket);
+		bool wait_for_connect(stream_protocol::socket& socket);
+		bool stop_requested();
+		void replay(stream_protocol::socket& socket);
+		void replay_known();
+		void send_datagrams(bool end_of_frame);
+		void add_to_datagram(const char* data, std::size_t size);
+		void send_datagram(bool last);
+		
+		enum : std::size_t { NO_RECORD = SIZE_MAX };
+		void start_worker();
+		void stop_worker();
+		void pin_worker();
+		void wait_for_write();
+		void write_completed(const boost::system::error_code& e, bool end_of_frame);
+		void append_set_led(uint16_t led, rgba_color col);
+		void append_range(uint16_t first, uint16_t last, rgba_color col);
+		void append_span(uint16_t first, const rgba_color* colors, std::size_t count);
+		void append_runs(uint16_t first, const rgba_color* colors, std::size_t count);
+		bool extend_open_record(uint16_t first, uint16_t last, rgba_color col);
+		void stage(uint16_t led, rgba_color col);
+		bool staging() const {
+			return _delta || _compact;
+		}
+		void allocate_staging();
+		void serialize_staged();
+		void merge_delta();
+		
+		// cmd_buffer (and send_buffer) never grow beyond this, everything before
+		// a command that wouldn't fit is sent without a strobe:
+		std::size_t _watermark = vlpp::client::DEFAULT_WATERMARK;
+		// set if sending a part of the current frame has failed:
+		bool _write_failed = false;
+		// the statistics; the bytes that the caller's commands need without any
+		// encoding minus the encoded bytes are the bytes saved:
+		std::atomic<uint64_t> _frames{0};
+		std::atomic<uint64_t> _records{0};
+		std::atomic<uint64_t> _bytes_sent{0};
+		std::atomic<uint64_t> _requested_bytes{0};
+		std::atomic<uint64_t> _encoded_bytes{0};
+		std::atomic<uint64_t> _writes{0};
+		atomic_histogram _flush_latency;
+		void count(std::atomic<uint64_t>& counter, std::size_t n) {
+			counter.fetch_add(n, std::memory_order_relaxed);
+		}
+		void frame_sent(std::chrono::steady_clock::time_point start);
+		// realtime-mode and the CPU of the worker in it:
+		bool _realtime = false;
+		unsigned _realtime_cpu = 0;
+		// the offset of the SET_LED or SET_RANGE at the end of cmd_buffer that the
+		// next command may extend if it continues it with the same color:
+		std::size_t _open_record = NO_RECORD;
+		// the headers and the buffer-sequence of submit(), kept to avoid allocations:
+		std::vector<char> _submit_headers;
+		std::vector<boost::asio::const_buffer> _submit_buffers;
+		// where drain() sends to while the monitor replays the last frame:
+		stream_protocol::socket* _replay_socket = nullptr;
+		// the offset of the server's clock for flush_at(), once sync_clock() was called:
+		bool _clock_synced = false;
+		std::chrono::nanoseconds _clock_offset{0};
+		
+		// the frame that is currently built (delta- or compaction-mode) and the last
+		// flushed one (delta-mode only), each bit in the masks belongs to the LED with
+		// the same index:
+		bool _delta = false;
+		bool _compact = false;
+		std::vector<rgba_color> _staged_colors;
+		std::vector<uint64_t> _staged_mask;
+		std::vector<rgba_color> _shadow_colors;
+		std::vector<uint64_t> _known_mask;
+		
+		// the buffer that is currently sent by the worker (async mode only) or by
+		// the event-loop (see async_flush()):
+		std::vector<char> send_buffer;
+		// the frame of async_flush() that is in flight:
+		bool _flush_in_flight = false;
+		std::size_t _flush_sent = 0;
+		completion_callback _flush_callback;
+		std::chrono::steady_clock::time_point _flush_start;
+		std::unique_ptr<io_service::work> _work;
+		std::thread _worker;
+		flush_callback _callback;
+		// protects the following members:
+		std::mutex _write_mutex;
+		std::condition_variable _write_done;
+		bool _write_pending = false;
+		std::exception_ptr _write_error;
+		
+		// everything the monitor needs to reconnect (resilient mode only):
+		std::vector<stream_protocol::endpoint> _endpoints;
+		std::string _token;
+		bool _resilient = false;
+		std::thread _monitor;
+		// protects the socket and the shadow-frame against the monitor:
+		std::mutex _connection_mutex;
+		bool _connected = true;
+		// protects _stop_monitoring:
+		std::mutex _monitor_mutex;
+		std::condition_variable _monitor_wakeup;
+		bool _stop_monitoring = false;
+		
+		// only open in udp-mode:
+		udp::socket _datagram_socket;
+		std::vector<char> _datagram;
+		uint64_t _digest = 0;
+		uint32_t _sequence = 0;
+		// whether datagrams of the current frame have been sent already:
+		bool _frame_open = false;
 };
 
 
-//opcodes:
-enum class opcodes: uint8_t {
-	SET_LED = 0x01,
-	AUTHENTICATE = 0x02,
-	STROBE = 0xFF
+
+enum : std::size_t { MASK_BITS = 64, MASK_SIZE = LED_COUNT / MASK_BITS };
+
+// the size of the commands:
+enum : std::size_t { SET_LED_SIZE = 7, HEADER_SIZE = 5, SET_RANGE_SIZE = 9, RUN_SIZE = 6 };
+
+// the delays between two attempts to reconnect and how long one attempt may take:
+const std::chrono::milliseconds MIN_BACKOFF(100);
+const std::chrono::milliseconds MAX_BACKOFF(5000);
+const std::chrono::milliseconds CONNECT_TIMEOUT(5000);
+// how long sync_clock() waits for the answer to a ping:
+const std::chrono::milliseconds PING_TIMEOUT(1000);
+
+namespace {
+
+/*
+ * Runs the function and translates its exceptions into a status for the
+ * noexcept-interface.
+ */
+template<typename Function>
+vlpp::client::status guarded(Function function) noexcept {
+	using status = vlpp::client::status;
+	try {
+		function();
+	}
+	catch (vlpp::connection_failure&) {
+		return status::connection_failure;
+	}
+	catch (std::invalid_argument&) {
+		return status::invalid_argument;
+	}
+	catch (...) {
+		return status::failure;
+	}
+	return status::ok;
+}
+
+/*
+ * A completion-condition for boost::asio::write() that transfers everything, like
+ * transfer_all(), and counts the write-syscalls: asio asks it before every one, and
+ * after the last one only if that failed.
+ */
+class counting_transfer {
+public:
+	explicit counting_transfer(std::atomic<uint64_t>& writes): _writes(writes) {}
+	
+	std::size_t operator()(const boost::system::error_code& e, std::size_t transferred) {
+		if (!e) {
+			_writes.fetch_add(1, std::memory_order_relaxed);
+		}
+		return boost::asio::transfer_all()(e, transferred);
+	}
+	
+private:
+	std::atomic<uint64_t>& _writes;
 };
 
-enum { TOKEN_SIZE = 16 };
+/*
+ * Disables Nagle's algorithm for tcp: the frames are written at once anyway, and a
+ * strobe or ping that follows the commands of send() must not wait for their
+ * acknowledgement.
+ */
+void disable_nagle(stream_protocol::socket& socket, const stream_protocol::endpoint& endpoint) {
+	if (endpoint.protocol().family() == AF_INET || endpoint.protocol().family() == AF_INET6) {
+		boost::system::error_code e;
+		socket.set_option(tcp::no_delay(true), e);
+	}
+}
+
+uint64_t nanoseconds_since_epoch(std::chrono::steady_clock::time_point time) {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		time.time_since_epoch()).count());
+}
+
+} // anonymous namespace
 
 ///////////
 
@@ -75,9 +338,42 @@ void vlpp::client::set_leds(const std::vector<uint16_t> &led_ids, const rgba_col
 	if(!_impl){
 		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
 	}
-	for (auto led: led_ids) {
-		set_led(led, col);
+	// consecutive IDs can be sent as one range:
+	std::size_t i = 0;
+	while (i < led_ids.size()) {
+		std::size_t j = i + 1;
+		while (j < led_ids.size() && led_ids[j - 1] != UINT16_MAX
+				&& led_ids[j] == led_ids[j - 1] + 1) {
+			++j;
+		}
+		if (j - i == 1) {
+			_impl->set_led(led_ids[i], col);
+		}
+		else {
+			_impl->set_led_range(led_ids[i], led_ids[j - 1], col);
+		}
+		i = j;
+	}
+}
+
+void vlpp::client::set_led_range(uint16_t first, uint16_t last, const rgba_color &col) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
+	}
+	if (last < first) {
+		throw std::invalid_argument("invalid range");
+	}
+	_impl->set_led_range(first, last, col);
+}
+
+void vlpp::client::set_leds(uint16_t first, const rgba_color *colors, std::size_t count) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
+	}
+	if (count > LED_COUNT - first) {
+		throw std::invalid_argument("invalid range");
 	}
+	_impl->set_leds(first, colors, count);
 }
 
 void vlpp::client::flush() {
@@ -87,26 +383,336 @@ void vlpp::client::flush() {
 	_impl->flush();
 }
 
+void vlpp::client::flush_at(std::chrono::steady_clock::time_point when) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
+	}
+	_impl->flush_at(when);
+}
+
+vlpp::client::clock_estimate vlpp::client::sync_clock(unsigned samples) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
+	}
+	if (samples == 0) {
+		throw std::invalid_argument("no samples");
+	}
+	return _impl->sync_clock(samples);
+}
+
+void vlpp::client::async_connect(boost::asio::io_context& io_service, const std::string &server,
+		const std::string &token, uint16_t port, completion_callback callback) {
+	if (token.length() != TOKEN_SIZE) {
+		throw std::invalid_argument("invalid token (wrong size)");
+	}
+	_impl = std::make_shared<vlpp::client::client_impl>(io_service);
+	_impl->async_connect(server, token, port, std::move(callback));
+}
+
+void vlpp::client::async_flush(completion_callback callback) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
+	}
+	_impl->async_flush(std::move(callback));
+}
+
+vlpp::client::status vlpp::client::try_set_led(uint16_t led_id, const rgba_color &col) noexcept {
+	if(!_impl){
+		return status::uninitialized;
+	}
+	return guarded([&] { _impl->set_led(led_id, col); });
+}
+
+vlpp::client::status vlpp::client::try_set_led_range(uint16_t first, uint16_t last,
+		const rgba_color &col) noexcept {
+	if(!_impl){
+		return status::uninitialized;
+	}
+	if (last < first) {
+		return status::invalid_argument;
+	}
+	return guarded([&] { _impl->set_led_range(first, last, col); });
+}
+
+vlpp::client::status vlpp::client::try_set_leds(uint16_t first, const rgba_color *colors,
+		std::size_t count) noexcept {
+	if(!_impl){
+		return status::uninitialized;
+	}
+	if (count > LED_COUNT - first) {
+		return status::invalid_argument;
+	}
+	return guarded([&] { _impl->set_leds(first, colors, count); });
+}
+
+vlpp::client::status vlpp::client::try_flush() noexcept {
+	if(!_impl){
+		return status::uninitialized;
+	}
+	return guarded([&] { _impl->flush(); });
+}
+
+void vlpp::client::send() {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
+	}
+	_impl->send();
+}
+
+void vlpp::client::submit(const frame_view& frame) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
+	}
+	_impl->submit(frame);
+}
+
+void vlpp::client::set_async(bool async, flush_callback callback) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
+	}
+	_impl->set_async(async, std::move(callback));
+}
+
+void vlpp::client::set_delta_mode(bool delta) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
+	}
+	_impl->set_delta_mode(delta);
+}
+
+void vlpp::client::set_compaction(bool compact) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
+	}
+	_impl->set_compaction(compact);
+}
+
+void vlpp::client::invalidate() {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
+	}
+	_impl->invalidate();
+}
+
+void vlpp::client::set_resilient(bool resilient) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
+	}
+	_impl->set_resilient(resilient);
+}
+
+bool vlpp::client::connected() {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
+	}
+	return _impl->connected();
+}
+
+void vlpp::client::set_watermark(std::size_t bytes) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
+	}
+	if (bytes < MIN_WATERMARK) {
+		throw std::invalid_argument("watermark too small");
+	}
+	_impl->set_watermark(bytes);
+}
+
+void vlpp::client::set_realtime(bool realtime, unsigned cpu) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
+	}
+	if (cpu >= CPU_SETSIZE) {
+		throw std::invalid_argument("invalid cpu");
+	}
+	_impl->set_realtime(realtime, cpu);
+}
+
+vlpp::client_stats vlpp::client::stats() const {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
+	}
+	return _impl->stats();
+}
+
+void vlpp::client::submit_set_leds(const char* commands, std::size_t count) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
+	}
+	_impl->submit_set_leds(commands, count);
+}
+
 std::vector<char>& vlpp::client::access_buffer(){
 	if(!_impl){
 		throw vlpp::uninitialized_error("uninitialized use of a vlpp::client");
 	}
-	return _impl->cmd_buffer;
+	return _impl->access_buffer();
 }
 
 ///////// now: the private stuff
 
 
 vlpp::client::client_impl::client_impl(const std::string &servername, const std::string &token, uint16_t port):
-	_socket(_io_service) {
+	_event_loop(_io_service),
+	_socket(_event_loop),
+	_datagram_socket(_event_loop) {
+	cmd_buffer.reserve(_watermark);
+	send_buffer.reserve(_watermark);
+	const std::string unix_prefix = "unix:";
+	const std::string udp_prefix = "udp:";
+	if (servername.compare(0, udp_prefix.size(), udp_prefix) == 0) {
+		connect_udp(servername.substr(udp_prefix.size()), port);
+		authenticate(token);
+		return;
+	}
+	if (servername.compare(0, unix_prefix.size(), unix_prefix) == 0) {
+		_endpoints.push_back(boost::asio::local::stream_protocol::endpoint(
+			servername.substr(unix_prefix.size())));
+	}
+	else {
+		resolve_tcp(servername, port);
+	}
+	boost::system::error_code e = boost::asio::error::host_not_found;
+	for (auto& endpoint: _endpoints) {
+		_socket.close();
+		_socket.connect(endpoint, e);
+		if (!e) {
+			disable_nagle(_socket, endpoint);
+			break;
+		}
+	}
+	if (e) {
+		throw vlpp::connection_failure("cannot connect to " + servername);
+	}
+	authenticate(token);
+}
+
+vlpp::client::client_impl::client_impl(io_service& event_loop):
+	_event_loop(event_loop),
+	_socket(_event_loop),
+	_datagram_socket(_event_loop) {
+	cmd_buffer.reserve(_watermark);
+	send_buffer.reserve(_watermark);
+}
+
+void vlpp::client::client_impl::async_connect(const std::string &servername, const std::string &token,
+		uint16_t port, completion_callback callback) {
+	const std::string unix_prefix = "unix:";
+	const std::string udp_prefix = "udp:";
+	auto self = shared_from_this();
+	_token = token;
+	if (servername.compare(0, udp_prefix.size(), udp_prefix) == 0) {
+		_digest = vlpp::token_digest(token);
+		_datagram.reserve(DATAGRAM_SIZE);
+		auto resolver = std::make_shared<udp::resolver>(_event_loop);
+		resolver->async_resolve(udp::resolver::query(servername.substr(udp_prefix.size()),
+				std::to_string(port)),
+			[self, resolver, servername, callback](const boost::system::error_code& e,
+					udp::resolver::results_type endpoints) {
+				boost::system::error_code error = e;
+				if (!error && endpoints.empty()) {
+					error = boost::asio::error::host_not_found;
+				}
+				if (!error) {
+					// connecting only sets the default destination, no packet is sent:
+					self->_datagram_socket.connect(*endpoints.begin(), error);
+				}
+				callback(error ? std::make_exception_ptr(vlpp::connection_failure(
+					"cannot connect to " + servername)) : nullptr);
+			});
+		return;
+	}
+	if (servername.compare(0, unix_prefix.size(), unix_prefix) == 0) {
+		_endpoints.push_back(boost::asio::local::stream_protocol::endpoint(
+			servername.substr(unix_prefix.size())));
+		connect_next(0, servername, std::move(callback));
+		return;
+	}
+	auto resolver = std::make_shared<tcp::resolver>(_event_loop);
+	resolver->async_resolve(tcp::resolver::query(servername, std::to_string(port)),
+		[self, resolver, servername, callback](const boost::system::error_code& e,
+				tcp::resolver::results_type endpoints) {
+			if (e) {
+				callback(std::make_exception_ptr(vlpp::connection_failure(
+					"cannot resolve " + servername)));
+				return;
+			}
+			for (auto& entry: endpoints) {
+				self->_endpoints.push_back(entry.endpoint());
+			}
+			self->connect_next(0, servername, callback);
+		});
+}
+
+/*
+ * Tries the endpoints from the index on, like the constructor, and sends the token
+ * to the first one that accepts the connection.
+ */
+void vlpp::client::client_impl::connect_next(std::size_t index, const std::string& servername,
+		completion_callback callback) {
+	if (index == _endpoints.size()) {
+		callback(std::make_exception_ptr(vlpp::connection_failure("cannot connect to " + servername)));
+		return;
+	}
+	auto self = shared_from_this();
+	boost::system::error_code ignored;
+	_socket.close(ignored);
+	_socket.async_connect(_endpoints[index],
+		[self, index, servername, callback](const boost::system::error_code& e) {
+			if (e) {
+				self->connect_next(index + 1, servername, callback);
+				return;
+			}
+			disable_nagle(self->_socket, self->_endpoints[index]);
+			auto auth_data = std::make_shared<std::array<char, TOKEN_SIZE + 1>>();
+			(*auth_data)[0] = static_cast<char>(opcodes::AUTHENTICATE);
+			std::copy(self->_token.begin(), self->_token.end(), auth_data->begin() + 1);
+			boost::asio::async_write(self->_socket, boost::asio::buffer(*auth_data),
+				[self, auth_data, callback](const boost::system::error_code& e, std::size_t n) {
+					self->count(self->_bytes_sent, n);
+					callback(e ? std::make_exception_ptr(vlpp::connection_failure("write failed"))
+						: nullptr);
+				});
+		});
+}
+
+void vlpp::client::client_impl::resolve_tcp(const std::string &servername, uint16_t port) {
 	tcp::resolver _resolver(_io_service);
 	tcp::resolver::query q(servername, std::to_string(port));
-	auto endpoints = _resolver.resolve(q);
-	boost::asio::connect(_socket, endpoints);
-	if (!_socket.is_open()) {
+	boost::system::error_code e;
+	auto endpoints = _resolver.resolve(q, e);
+	if (e) {
+		throw vlpp::connection_failure("cannot resolve " + servername);
+	}
+	for (auto& entry: endpoints) {
+		_endpoints.push_back(entry.endpoint());
+	}
+}
+
+void vlpp::client::client_impl::connect_udp(const std::string &servername, uint16_t port) {
+	udp::resolver _resolver(_io_service);
+	udp::resolver::query q(servername, std::to_string(port));
+	boost::system::error_code e;
+	auto endpoints = _resolver.resolve(q, e);
+	if (e || endpoints.empty()) {
+		throw vlpp::connection_failure("cannot resolve " + servername);
+	}
+	// connecting only sets the default destination, no packet is sent:
+	_datagram_socket.connect(*endpoints.begin(), e);
+	if (e) {
 		throw vlpp::connection_failure("cannot open socket");
 	}
-	authenticate(token);
+	_datagram.reserve(DATAGRAM_SIZE);
+}
+
+vlpp::client::client_impl::~client_impl() {
+	stop_monitor();
+	try {
+		stop_worker();
+	}
+	catch (vlpp::connection_failure&) {
+		// nobody is left to report this to
+	}
 }
 
 void vlpp::client::client_impl::authenticate(const std::string &token) {
@@ -114,35 +720,1312 @@ void vlpp::client::client_impl::authenticate(const std::string &token) {
 	if (token.length() != TOKEN_SIZE) {
 		throw std::invalid_argument("invalid token (wrong size)");
 	}
+	if (_datagram_socket.is_open()) {
+		// every datagram is authenticated on its own:
+		_digest = vlpp::token_digest(token);
+		return;
+	}
+	std::lock_guard<std::mutex> lock(_connection_mutex);
+	_token = token;
+	if (!_connected) {
+		// the monitor will use the new token
+		return;
+	}
+	try {
+		// the worker must not use the socket at the same time:
+		wait_for_write();
+		boost::system::error_code e;
+		bool non_blocking = _socket.non_blocking();
+		_socket.non_blocking(false);
+		send_token(_socket, token, e);
+		_socket.non_blocking(non_blocking);
+		if (e) {
+			throw vlpp::connection_failure("write failed");
+		}
+	}
+	catch (vlpp::connection_failure&) {
+		if (!_resilient) {
+			throw;
+		}
+		_connected = false;
+	}
+}
+
+void vlpp::client::client_impl::send_token(stream_protocol::socket& socket,
+		const std::string& token, boost::system::error_code& e) {
 	std::array<char,TOKEN_SIZE+1> auth_data;
 	auth_data[0] = static_cast<char>(opcodes::AUTHENTICATE);
 	for (size_t i = 0; i < TOKEN_SIZE; ++i) {
 		auth_data[i+1] = static_cast<char>(token[i]);
 	}
+	boost::asio::write(socket, boost::asio::buffer(&(auth_data[0]), auth_data.size()) , e);
+}
+
+void vlpp::client::client_impl::set_led(uint16_t led, rgba_color col) {
+	VLPP_TRACE_SCOPE("set_led");
+	count(_requested_bytes, SET_LED_SIZE);
+	if (staging()) {
+		stage(led, col);
+	}
+	else {
+		append_set_led(led, col);
+	}
+}
+
+void vlpp::client::client_impl::set_led_range(uint16_t first, uint16_t last, rgba_color col) {
+	VLPP_TRACE_SCOPE("set_led_range");
+	count(_requested_bytes, SET_RANGE_SIZE);
+	if (staging()) {
+		for (std::size_t led = first; led <= last; ++led) {
+			stage(static_cast<uint16_t>(led), col);
+		}
+	}
+	else {
+		append_range(first, last, col);
+	}
+}
+
+void vlpp::client::client_impl::set_leds(uint16_t first, const rgba_color* colors, std::size_t count) {
+	VLPP_TRACE_SCOPE("set_leds");
+	if (count) {
+		this->count(_requested_bytes, HEADER_SIZE + count * sizeof(rgba_color));
+	}
+	if (staging()) {
+		for (std::size_t i = 0; i < count; ++i) {
+			stage(static_cast<uint16_t>(first + i), colors[i]);
+		}
+	}
+	else {
+		append_span(first, colors, count);
+	}
+}
+
+void vlpp::client::client_impl::stage(uint16_t led, rgba_color col) {
+	_staged_colors[led] = col;
+	_staged_mask[led / MASK_BITS] |= uint64_t(1) << (led % MASK_BITS);
+}
+
+void vlpp::client::client_impl::append(const char* data, std::size_t size) {
+	if (cmd_buffer.size() + size > _watermark) {
+		drain();
+	}
+	_open_record = NO_RECORD;
+	cmd_buffer.insert(cmd_buffer.end(), data, data + size);
+	count(_records, 1);
+	count(_encoded_bytes, size);
+}
+
+void vlpp::client::client_impl::append_set_led(uint16_t led, rgba_color col) {
+	if (extend_open_record(led, led, col)) {
+		return;
+	}
+	const char command[SET_LED_SIZE] = {
+		static_cast<char>(opcodes::SET_LED),
+		static_cast<char>(led >> 8), static_cast<char>(led & 0xff),
+		static_cast<char>(col.red), static_cast<char>(col.green),
+		static_cast<char>(col.blue), static_cast<char>(col.alpha)
+	};
+	append(command, sizeof(command));
+	_open_record = cmd_buffer.size() - SET_LED_SIZE;
+}
+
+void vlpp::client::client_impl::append_span(uint16_t first, const rgba_color* colors,
+		std::size_t count) {
+	if (count == 0) {
+		return;
+	}
+	if (count == 1) {
+		append_set_led(first, colors[0]);
+		return;
+	}
+	std::size_t runs = 1;
+	for (std::size_t i = 1; i < count; ++i) {
+		if (colors[i] != colors[i - 1]) {
+			++runs;
+		}
+	}
+	if (runs == 1) {
+		append_range(first, static_cast<uint16_t>(first + count - 1), colors[0]);
+		return;
+	}
+	if (runs * RUN_SIZE < count * sizeof(rgba_color)) {
+		append_runs(first, colors, count);
+		return;
+	}
+	_open_record = NO_RECORD;
+	// spans that don't fit into the buffer are split:
+	while (count) {
+		if (cmd_buffer.size() + HEADER_SIZE + sizeof(rgba_color) > _watermark) {
+			drain();
+		}
+		std::size_t n = std::min(count,
+			(_watermark - cmd_buffer.size() - HEADER_SIZE) / sizeof(rgba_color));
+		std::size_t span_last = first + n - 1;
+		const char header[HEADER_SIZE] = {
+			static_cast<char>(opcodes::SET_LEDS),
+			static_cast<char>(first >> 8), static_cast<char>(first & 0xff),
+			static_cast<char>(span_last >> 8), static_cast<char>(span_last & 0xff)
+		};
+		cmd_buffer.insert(cmd_buffer.end(), header, header + HEADER_SIZE);
+		auto data = reinterpret_cast<const char*>(colors);
+		cmd_buffer.insert(cmd_buffer.end(), data, data + n * sizeof(rgba_color));
+		this->count(_records, 1);
+		this->count(_encoded_bytes, HEADER_SIZE + n * sizeof(rgba_color));
+		first = static_cast<uint16_t>(first + n);
+		colors += n;
+		count -= n;
+	}
+}
+
+void vlpp::client::client_impl::append_runs(uint16_t first, const rgba_color* colors,
+		std::size_t count) {
+	_open_record = NO_RECORD;
+	std::size_t i = 0;
+	// like spans, long runs of runs are split if they don't fit into the buffer:
+	while (i < count) {
+		if (cmd_buffer.size() + HEADER_SIZE + RUN_SIZE > _watermark) {
+			drain();
+		}
+		std::size_t max_runs = std::min<std::size_t>(UINT16_MAX,
+			(_watermark - cmd_buffer.size() - HEADER_SIZE) / RUN_SIZE);
+		std::size_t header = cmd_buffer.size();
+		cmd_buffer.resize(header + HEADER_SIZE);
+		std::size_t runs = 0;
+		std::size_t record_first = first + i;
+		for (; runs < max_runs && i < count; ++runs) {
+			std::size_t length = 1;
+			while (i + length < count && colors[i + length] == colors[i]) {
+				++length;
+			}
+			const rgba_color& col = colors[i];
+			const char run[RUN_SIZE] = {
+				static_cast<char>(length >> 8), static_cast<char>(length & 0xff),
+				static_cast<char>(col.red), static_cast<char>(col.green),
+				static_cast<char>(col.blue), static_cast<char>(col.alpha)
+			};
+			cmd_buffer.insert(cmd_buffer.end(), run, run + RUN_SIZE);
+			i += length;
+		}
+		cmd_buffer[header] = static_cast<char>(opcodes::SET_RLE);
+		cmd_buffer[header + 1] = static_cast<char>(record_first >> 8);
+		cmd_buffer[header + 2] = static_cast<char>(record_first & 0xff);
+		cmd_buffer[header + 3] = static_cast<char>(runs >> 8);
+		cmd_buffer[header + 4] = static_cast<char>(runs & 0xff);
+		this->count(_records, 1);
+		this->count(_encoded_bytes, HEADER_SIZE + runs * RUN_SIZE);
+	}
+}
+
+/*
+ * Turns a SET_LED or SET_RANGE at the end of the buffer into a longer SET_RANGE
+ * if [first, last] continues it with the same color, so that filling a line of
+ * LEDs one by one costs no more than one SET_RANGE.
+ */
+bool vlpp::client::client_impl::extend_open_record(uint16_t first, uint16_t last,
+		rgba_color col) {
+	// the record must still be the complete end of the buffer:
+	if (_open_record == NO_RECORD || _open_record + SET_LED_SIZE > cmd_buffer.size()) {
+		return false;
+	}
+	char* record = &cmd_buffer[_open_record];
+	bool single = static_cast<opcodes>(record[0]) == opcodes::SET_LED;
+	std::size_t size = single ? SET_LED_SIZE : SET_RANGE_SIZE;
+	if (_open_record + size != cmd_buffer.size()) {
+		return false;
+	}
+	const char* id = single ? record + 1 : record + 3;
+	std::size_t record_last = static_cast<std::size_t>(static_cast<uint8_t>(id[0]) << 8
+		| static_cast<uint8_t>(id[1]));
+	if (record_last + 1 != first
+			|| std::memcmp(record + size - sizeof(rgba_color), &col, sizeof(rgba_color))) {
+		return false;
+	}
+	if (single) {
+		if (cmd_buffer.size() + SET_RANGE_SIZE - SET_LED_SIZE > _watermark) {
+			return false;
+		}
+		// <SET_LED> <id> <rgba> becomes <SET_RANGE> <id> <id> <rgba>; the id is copied
+		// first, insert() must not read from the vector it inserts into:
+		const char id_copy[2] = {record[1], record[2]};
+		cmd_buffer.insert(cmd_buffer.begin() + static_cast<std::ptrdiff_t>(_open_record) + 3,
+			id_copy, id_copy + 2);
+		record = &cmd_buffer[_open_record];
+		record[0] = static_cast<char>(opcodes::SET_RANGE);
+		count(_encoded_bytes, SET_RANGE_SIZE - SET_LED_SIZE);
+	}
+	record[3] = static_cast<char>(last >> 8);
+	record[4] = static_cast<char>(last & 0xff);
+	return true;
+}
+
+void vlpp::client::client_impl::append_range(uint16_t first, uint16_t last, rgba_color col) {
+	if (extend_open_record(first, last, col)) {
+		return;
+	}
+	const char command[SET_RANGE_SIZE] = {
+		static_cast<char>(opcodes::SET_RANGE),
+		static_cast<char>(first >> 8), static_cast<char>(first & 0xff),
+		static_cast<char>(last >> 8), static_cast<char>(last & 0xff),
+		static_cast<char>(col.red), static_cast<char>(col.green),
+		static_cast<char>(col.blue), static_cast<char>(col.alpha)
+	};
+	append(command, sizeof(command));
+	_open_record = cmd_buffer.size() - SET_RANGE_SIZE;
+}
+
+void vlpp::client::client_impl::drain() {
+	if (cmd_buffer.empty()) {
+		return;
+	}
+	if (_replay_socket) {
+		boost::system::error_code e;
+		count(_bytes_sent, boost::asio::write(*_replay_socket, boost::asio::buffer(cmd_buffer),
+			counting_transfer(_writes), e));
+		clear_commands();
+		if (e) {
+			throw vlpp::connection_failure("write failed");
+		}
+		return;
+	}
+	if (_write_failed) {
+		clear_commands();
+		return;
+	}
+	try {
+		if (_datagram_socket.is_open()) {
+			send_datagrams(false);
+		}
+		else {
+			write_buffer(false);
+		}
+	}
+	catch (vlpp::connection_failure&) {
+		// the frame must still be built completely (the shadow-frame of the
+		// delta-mode relies on it), so the error is reported by flush():
+		_write_failed = true;
+		clear_commands();
+	}
+}
+
+void vlpp::client::client_impl::flush() {
+	const char strobe = static_cast<char>(opcodes::STROBE);
+	flush_frame(&strobe, 1);
+}
+
+void vlpp::client::client_impl::flush_at(std::chrono::steady_clock::time_point when) {
+	if (_datagram_socket.is_open()) {
+		throw std::logic_error("no timed strobes in udp-mode");
+	}
+	if (!_clock_synced) {
+		throw std::logic_error("the clock of the server is unknown");
+	}
+	char strobe[1 + vlpp::TIMESTAMP_SIZE];
+	strobe[0] = static_cast<char>(opcodes::STROBE_AT);
+	vlpp::write_timestamp(nanoseconds_since_epoch(when + _clock_offset), strobe + 1);
+	flush_frame(strobe, sizeof(strobe));
+}
+
+void vlpp::client::client_impl::flush_frame(const char* strobe, std::size_t size) {
+	if (!_resilient) {
+		send_frame(strobe, size);
+		return;
+	}
+	std::lock_guard<std::mutex> lock(_connection_mutex);
+	if (!_connected) {
+		// only the latest state is kept (in the shadow-frame), the monitor replays it:
+		merge_delta();
+		return;
+	}
+	try {
+		send_frame(strobe, size);
+	}
+	catch (vlpp::connection_failure&) {
+		// the monitor notices this soon:
+		_connected = false;
+	}
+}
+
+void vlpp::client::client_impl::async_flush(completion_callback callback) {
+	if (!external_loop() || _resilient || _datagram_socket.is_open()) {
+		// there is no event-loop to wait on, or nothing to wait for:
+		std::exception_ptr error;
+		try {
+			flush();
+		}
+		catch (std::exception&) {
+			error = std::current_exception();
+		}
+		callback(error);
+		return;
+	}
+	if (_flush_in_flight) {
+		throw std::logic_error("the previous frame is still in flight");
+	}
+	VLPP_TRACE_SCOPE("async flush");
+	_flush_start = std::chrono::steady_clock::now();
+	if (staging()) {
+		serialize_staged();
+	}
+	const char strobe = static_cast<char>(opcodes::STROBE);
+	count(_requested_bytes, 1);
+	append(&strobe, 1);
+	if (_write_failed) {
+		_write_failed = false;
+		clear_commands();
+		_event_loop.post([callback] {
+			callback(std::make_exception_ptr(vlpp::connection_failure("write failed")));
+		});
+		return;
+	}
+	std::swap(cmd_buffer, send_buffer);
+	_flush_sent = 0;
+	_flush_in_flight = true;
+	_flush_callback = std::move(callback);
+	continue_flush();
+}
+
+/*
+ * Writes as much of the frame of async_flush() as the socket accepts and waits on
+ * the event-loop until it accepts more.
+ */
+void vlpp::client::client_impl::continue_flush() {
+	while (_flush_sent < send_buffer.size()) {
+		// the socket stays blocking for the other methods, so this write must not block:
+		ssize_t written = ::send(_socket.native_handle(), send_buffer.data() + _flush_sent,
+			send_buffer.size() - _flush_sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (written < 0 && errno == EINTR) {
+			continue;
+		}
+		if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			auto self = shared_from_this();
+			_socket.async_wait(stream_protocol::socket::wait_write,
+				[self](const boost::system::error_code& e) {
+					if (e == boost::asio::error::operation_aborted) {
+						// finish_flush() has sent the rest
+						return;
+					}
+					if (e) {
+						self->flush_completed(std::make_exception_ptr(
+							vlpp::connection_failure("write failed")));
+						return;
+					}
+					self->continue_flush();
+				});
+			return;
+		}
+		if (written < 0) {
+			flush_completed(std::make_exception_ptr(vlpp::connection_failure("write failed")));
+			return;
+		}
+		count(_writes, 1);
+		count(_bytes_sent, static_cast<std::size_t>(written));
+		_flush_sent += static_cast<std::size_t>(written);
+	}
+	flush_completed(nullptr);
+}
+
+/*
+ * Sends the rest of the frame of async_flush() with a blocking write, for the methods
+ * that need the socket right away.
+ */
+void vlpp::client::client_impl::finish_flush() {
+	if (!_flush_in_flight) {
+		return;
+	}
+	boost::system::error_code e;
+	count(_bytes_sent, boost::asio::write(_socket, boost::asio::buffer(send_buffer) + _flush_sent,
+		counting_transfer(_writes), e));
+	boost::system::error_code ignored;
+	_socket.cancel(ignored);
+	flush_completed(e ? std::make_exception_ptr(vlpp::connection_failure("write failed")) : nullptr);
+}
+
+void vlpp::client::client_impl::flush_completed(std::exception_ptr error) {
+	_flush_in_flight = false;
+	send_buffer.clear();
+	if (!error) {
+		frame_sent(_flush_start);
+	}
+	// never call back from within async_flush(), a coroutine would be resumed
+	// before it is suspended completely:
+	auto callback = std::move(_flush_callback);
+	_flush_callback = nullptr;
+	_event_loop.post([callback, error] {
+		callback(error);
+	});
+}
+
+vlpp::client::clock_estimate vlpp::client::client_impl::sync_clock(unsigned samples) {
+	if (_datagram_socket.is_open()) {
+		throw std::logic_error("no clock synchronization in udp-mode");
+	}
+	std::lock_guard<std::mutex> lock(_connection_mutex);
+	if (!_connected) {
+		throw vlpp::connection_failure("not connected");
+	}
+	clock_estimate best = {std::chrono::nanoseconds::zero(), std::chrono::nanoseconds::max()};
+	try {
+		// the worker must not use the socket at the same time:
+		wait_for_write();
+		bool non_blocking = _socket.non_blocking();
+		_socket.non_blocking(false);
+		try {
+			for (unsigned i = 0; i < samples; ++i) {
+				auto sample = ping();
+				if (sample.round_trip < best.round_trip) {
+					best = sample;
+				}
+			}
+		}
+		catch (vlpp::connection_failure&) {
+			_socket.non_blocking(non_blocking);
+			throw;
+		}
+		_socket.non_blocking(non_blocking);
+	}
+	catch (vlpp::connection_failure&) {
+		if (_resilient) {
+			// the monitor reconnects:
+			_connected = false;
+		}
+		throw;
+	}
+	_clock_offset = best.offset;
+	_clock_synced = true;
+	return best;
+}
+
+vlpp::client::clock_estimate vlpp::client::client_impl::ping() {
+	auto sent = std::chrono::steady_clock::now();
+	uint64_t client_time = nanoseconds_since_epoch(sent);
+	char request[1 + vlpp::TIMESTAMP_SIZE];
+	request[0] = static_cast<char>(opcodes::PING);
+	vlpp::write_timestamp(client_time, request + 1);
 	boost::system::error_code e;
-	boost::asio::write(_socket, boost::asio::buffer(&(auth_data[0]), auth_data.size()) , e);
+	count(_bytes_sent, boost::asio::write(_socket, boost::asio::buffer(request),
+		counting_transfer(_writes), e));
 	if (e) {
 		throw vlpp::connection_failure("write failed");
 	}
+	// answers to the pings of a failed sync_clock() may arrive late, they are skipped:
+	auto deadline = sent + PING_TIMEOUT;
+	std::array<char, vlpp::PING_REPLY_SIZE> reply;
+	do {
+		pollfd fd = {_socket.native_handle(), POLLIN, 0};
+		auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+			deadline - std::chrono::steady_clock::now());
+		int ready = ::poll(&fd, 1, static_cast<int>(std::max<std::chrono::milliseconds::rep>(
+			timeout.count(), 0)));
+		if (ready < 0 && errno == EINTR) {
+			continue;
+		}
+		if (ready <= 0) {
+			throw vlpp::connection_failure("no answer to ping");
+		}
+		boost::asio::read(_socket, boost::asio::buffer(reply), e);
+		if (e || static_cast<opcodes>(reply[0]) != opcodes::PING) {
+			throw vlpp::connection_failure("invalid answer to ping");
+		}
+	} while (vlpp::read_timestamp(reply.data() + 1) != client_time);
+	auto round_trip = std::chrono::steady_clock::now() - sent;
+	std::chrono::nanoseconds server_time(vlpp::read_timestamp(reply.data() + 1 + vlpp::TIMESTAMP_SIZE));
+	// the server has read its clock halfway through the round-trip:
+	return {server_time - std::chrono::duration_cast<std::chrono::nanoseconds>(
+		(sent + round_trip / 2).time_since_epoch()), round_trip};
 }
 
-void vlpp::client::client_impl::set_led(uint16_t led, rgba_color col) {
-	cmd_buffer.push_back(static_cast<char>(opcodes::SET_LED));
-	cmd_buffer.push_back(static_cast<char>((led >> 8)));
-	cmd_buffer.push_back(static_cast<char>((led & 0xff)));
-	cmd_buffer.push_back(static_cast<char>(col.red));
-	cmd_buffer.push_back(static_cast<char>(col.green));
-	cmd_buffer.push_back(static_cast<char>(col.blue));
-	cmd_buffer.push_back(static_cast<char>(col.alpha));
+void vlpp::client::client_impl::send() {
+	VLPP_TRACE_SCOPE("send");
+	std::unique_lock<std::mutex> lock(_connection_mutex, std::defer_lock);
+	if (_resilient) {
+		lock.lock();
+		if (!_connected) {
+			// the next flush() merges the staged changes:
+			return;
+		}
+	}
+	if (staging()) {
+		serialize_staged();
+	}
+	// errors are remembered for flush():
+	drain();
 }
 
-void vlpp::client::client_impl::flush() {
-	cmd_buffer.push_back(static_cast<char>(opcodes::STROBE));
+void vlpp::client::client_impl::send_frame(const char* strobe, std::size_t size) {
+	VLPP_TRACE_SCOPE("flush");
+	auto start = std::chrono::steady_clock::now();
+	if (staging()) {
+		serialize_staged();
+	}
+	if (!_datagram_socket.is_open()) {
+		count(_requested_bytes, size);
+		append(strobe, size);
+	}
+	if (_write_failed) {
+		_write_failed = false;
+		clear_commands();
+		_frame_open = false;
+		throw vlpp::connection_failure("write failed");
+	}
+	if (_datagram_socket.is_open()) {
+		send_datagrams(true);
+		if (_callback) {
+			_callback(nullptr);
+		}
+		frame_sent(start);
+		return;
+	}
+	write_buffer(true);
+	frame_sent(start);
+}
+
+void vlpp::client::client_impl::frame_sent(std::chrono::steady_clock::time_point start) {
+	count(_frames, 1);
+	_flush_latency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start).count()));
+}
+
+vlpp::client_stats vlpp::client::client_impl::stats() const {
+	client_stats result;
+	result.frames = _frames.load(std::memory_order_relaxed);
+	result.records = _records.load(std::memory_order_relaxed);
+	result.bytes_sent = _bytes_sent.load(std::memory_order_relaxed);
+	result.bytes_saved = static_cast<int64_t>(_requested_bytes.load(std::memory_order_relaxed)
+		- _encoded_bytes.load(std::memory_order_relaxed));
+	result.writes = _writes.load(std::memory_order_relaxed);
+	result.flush_latency = _flush_latency.snapshot();
+	return result;
+}
+
+void vlpp::client::client_impl::write_buffer(bool end_of_frame) {
+	VLPP_TRACE_SCOPE("write");
+	if (!_worker.joinable()) {
+		finish_flush();
+		boost::system::error_code e;
+		count(_bytes_sent, boost::asio::write(_socket, boost::asio::buffer(cmd_buffer),
+			counting_transfer(_writes), e));
+		clear_commands();
+		if (e) {
+			throw vlpp::connection_failure("write failed");
+		}
+		return;
+	}
+	try {
+		wait_for_write();
+	}
+	catch (vlpp::connection_failure&) {
+		clear_commands();
+		throw;
+	}
+	// most frames fit into the socket-buffer of the kernel, so try to get rid of
+	// them without waking up the worker (the socket is non-blocking now):
+	boost::system::error_code e;
+	std::size_t written = _socket.write_some(boost::asio::buffer(cmd_buffer), e);
+	count(_writes, 1);
+	if (e == boost::asio::error::would_block) {
+		written = 0;
+	}
+	else if (e) {
+		clear_commands();
+		throw vlpp::connection_failure("write failed");
+	}
+	count(_bytes_sent, written);
+	if (written == cmd_buffer.size()) {
+		clear_commands();
+		if (end_of_frame && _callback) {
+			_callback(nullptr);
+		}
+		return;
+	}
+	// the worker is idle, so we can take its buffer and let it send the rest:
+	std::swap(cmd_buffer, send_buffer);
+	clear_commands();
+	{
+		std::lock_guard<std::mutex> lock(_write_mutex);
+		_write_pending = true;
+	}
+	_io_service.post([this, written, end_of_frame] {
+#ifdef VLPP_TRACING
+		auto begin = vlpp::trace::clock::now();
+#endif
+		boost::asio::async_write(_socket, boost::asio::buffer(send_buffer) + written,
+			counting_transfer(_writes),
+			[=](const boost::system::error_code& e, std::size_t n) {
+#ifdef VLPP_TRACING
+				vlpp::trace::record("async write", begin, vlpp::trace::clock::now());
+#endif
+				count(_bytes_sent, n);
+				write_completed(e, end_of_frame);
+			});
+	});
+}
+
+void vlpp::client::client_impl::submit(const frame_view& frame) {
+	if (staging() || _datagram_socket.is_open()) {
+		for (auto& span: frame.spans()) {
+			set_leds(span.first, span.colors, span.count);
+		}
+		flush();
+		return;
+	}
+	auto start = std::chrono::steady_clock::now();
+	VLPP_TRACE_SCOPE("submit");
+	begin_submit();
+	// all headers are written before the buffers point into them:
+	_submit_headers.resize(frame.spans().size() * HEADER_SIZE + 1);
+	char* header = _submit_headers.data();
+	for (auto& span: frame.spans()) {
+		std::size_t last = span.first + span.count - 1;
+		header[0] = static_cast<char>(opcodes::SET_LEDS);
+		header[1] = static_cast<char>(span.first >> 8);
+		header[2] = static_cast<char>(span.first & 0xff);
+		header[3] = static_cast<char>(last >> 8);
+		header[4] = static_cast<char>(last & 0xff);
+		_submit_buffers.push_back(boost::asio::buffer(header, HEADER_SIZE));
+		_submit_buffers.push_back(boost::asio::buffer(span.colors, span.count * sizeof(rgba_color)));
+		header += HEADER_SIZE;
+	}
+	*header = static_cast<char>(opcodes::STROBE);
+	_submit_buffers.push_back(boost::asio::buffer(header, 1));
+	finish_submit(start, frame.spans().size() + 1);
+}
+
+void vlpp::client::client_impl::submit_set_leds(const char* commands, std::size_t count) {
+	if (staging() || _datagram_socket.is_open()) {
+		for (std::size_t i = 0; i < count; ++i, commands += SET_LED_SIZE) {
+			rgba_color color;
+			std::memcpy(&color, commands + 3, sizeof(color));
+			set_led(static_cast<uint16_t>(static_cast<uint8_t>(commands[1]) << 8
+				| static_cast<uint8_t>(commands[2])), color);
+		}
+		flush();
+		return;
+	}
+	auto start = std::chrono::steady_clock::now();
+	VLPP_TRACE_SCOPE("submit");
+	begin_submit();
+	// the commands end with the strobe:
+	_submit_buffers.push_back(boost::asio::buffer(commands, count * SET_LED_SIZE + 1));
+	finish_submit(start, count + 1);
+}
+
+/*
+ * Starts the buffer-sequence of a frame that is written from the memory of the
+ * caller with the commands that were set before.
+ */
+void vlpp::client::client_impl::begin_submit() {
+	if (_write_failed) {
+		_write_failed = false;
+		clear_commands();
+		throw vlpp::connection_failure("write failed");
+	}
+	_submit_buffers.clear();
+	if (!cmd_buffer.empty()) {
+		_submit_buffers.push_back(boost::asio::buffer(cmd_buffer));
+	}
+}
+
+/*
+ * Writes the buffer-sequence of a frame at once.
+ */
+void vlpp::client::client_impl::finish_submit(std::chrono::steady_clock::time_point start,
+		std::size_t records) {
+	finish_flush();
+	if (_worker.joinable()) {
+		try {
+			wait_for_write();
+		}
+		catch (vlpp::connection_failure&) {
+			clear_commands();
+			throw;
+		}
+	}
 	boost::system::error_code e;
-	boost::asio::write(_socket, boost::asio::buffer(&(cmd_buffer[0]), cmd_buffer.size()), e);
-	cmd_buffer.clear();
+	bool non_blocking = _socket.non_blocking();
+	_socket.non_blocking(false);
+	count(_bytes_sent, boost::asio::write(_socket, _submit_buffers, counting_transfer(_writes), e));
+	_socket.non_blocking(non_blocking);
+	clear_commands();
 	if (e) {
 		throw vlpp::connection_failure("write failed");
 	}
+	count(_records, records);
+	if (_worker.joinable() && _callback) {
+		_callback(nullptr);
+	}
+	frame_sent(start);
+}
+
+void vlpp::client::client_impl::set_watermark(std::size_t bytes) {
+	std::lock_guard<std::mutex> lock(_connection_mutex);
+	// the worker must not send from a buffer that is reallocated:
+	wait_for_write();
+	if (cmd_buffer.size() > bytes) {
+		drain();
+	}
+	_watermark = bytes;
+	std::vector<char>(cmd_buffer).swap(cmd_buffer);
+	cmd_buffer.reserve(bytes);
+	std::vector<char>().swap(send_buffer);
+	send_buffer.reserve(bytes);
+}
+
+void vlpp::client::client_impl::set_realtime(bool realtime, unsigned cpu) {
+	std::lock_guard<std::mutex> lock(_connection_mutex);
+	if (realtime) {
+		if (mlockall(MCL_CURRENT | MCL_FUTURE)) {
+			throw std::system_error(errno, std::system_category(), "mlockall failed");
+		}
+	}
+	else if (_realtime) {
+		munlockall();
+	}
+	_realtime = realtime;
+	_realtime_cpu = cpu;
+	if (_worker.joinable()) {
+		pin_worker();
+	}
 }
 
+/*
+ * Restricts the worker to the CPU of realtime-mode or to the CPUs of the
+ * calling thread outside of it.
+ */
+void vlpp::client::client_impl::pin_worker() {
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	if (_realtime) {
+		CPU_SET(_realtime_cpu, &cpus);
+	}
+	else if (sched_getaffinity(0, sizeof(cpus), &cpus)) {
+		throw std::system_error(errno, std::system_category(), "sched_getaffinity failed");
+	}
+	int error = pthread_setaffinity_np(_worker.native_handle(), sizeof(cpus), &cpus);
+	if (error) {
+		throw std::system_error(error, std::system_category(), "pinning the worker failed");
+	}
+}
+
+void vlpp::client::client_impl::set_delta_mode(bool delta) {
+	std::lock_guard<std::mutex> lock(_connection_mutex);
+	if (delta == _delta) {
+		return;
+	}
+	if (_resilient) {
+		throw std::logic_error("resilient mode requires delta mode");
+	}
+	if (delta) {
+		allocate_staging();
+		_shadow_colors.assign(LED_COUNT, rgba_color());
+		_known_mask.assign(MASK_SIZE, 0);
+	}
+	else {
+		if (!_compact) {
+			// don't lose the changes of the current frame:
+			serialize_staged();
+			std::vector<rgba_color>().swap(_staged_colors);
+			std::vector<uint64_t>().swap(_staged_mask);
+		}
+		std::vector<rgba_color>().swap(_shadow_colors);
+		std::vector<uint64_t>().swap(_known_mask);
+	}
+	_delta = delta;
+}
+
+void vlpp::client::client_impl::set_compaction(bool compact) {
+	std::lock_guard<std::mutex> lock(_connection_mutex);
+	if (compact == _compact) {
+		return;
+	}
+	if (compact) {
+		allocate_staging();
+	}
+	else if (!_delta) {
+		// don't lose the changes of the current frame:
+		serialize_staged();
+		std::vector<rgba_color>().swap(_staged_colors);
+		std::vector<uint64_t>().swap(_staged_mask);
+	}
+	_compact = compact;
+}
+
+void vlpp::client::client_impl::allocate_staging() {
+	if (!staging()) {
+		_staged_colors.assign(LED_COUNT, rgba_color());
+		_staged_mask.assign(MASK_SIZE, 0);
+	}
+}
+
+void vlpp::client::client_impl::invalidate() {
+	std::lock_guard<std::mutex> lock(_connection_mutex);
+	if (!_delta) {
+		return;
+	}
+	// stage every LED the server knew about, unless it already has a new color:
+	for (std::size_t i = 0; i < MASK_SIZE; ++i) {
+		uint64_t stale = _known_mask[i] & ~_staged_mask[i];
+		while (stale) {
+			std::size_t led = i * MASK_BITS + static_cast<std::size_t>(__builtin_ctzll(stale));
+			_staged_colors[led] = _shadow_colors[led];
+			stale &= stale - 1;
+		}
+		_staged_mask[i] |= _known_mask[i];
+		_known_mask[i] = 0;
+	}
+}
+
+void vlpp::client::client_impl::serialize_staged() {
+	VLPP_TRACE_SCOPE("serialize");
+	// every staged LED is sent once, with the color it was set to last; in delta-mode
+	// only if the server doesn't know that color already. Changed LEDs with
+	// consecutive IDs are collected and sent as one span:
+	std::size_t span_first = 0;
+	std::size_t span_count = 0;
+	for (std::size_t i = 0; i < MASK_SIZE; ++i) {
+		uint64_t staged = _staged_mask[i];
+		_staged_mask[i] = 0;
+		while (staged) {
+			unsigned bit = static_cast<unsigned>(__builtin_ctzll(staged));
+			std::size_t led = i * MASK_BITS + bit;
+			staged &= staged - 1;
+			if (_delta) {
+				uint64_t mask = uint64_t(1) << bit;
+				if ((_known_mask[i] & mask) && _shadow_colors[led] == _staged_colors[led]) {
+					continue;
+				}
+				_shadow_colors[led] = _staged_colors[led];
+				_known_mask[i] |= mask;
+			}
+			if (span_count && led == span_first + span_count) {
+				++span_count;
+				continue;
+			}
+			append_span(static_cast<uint16_t>(span_first), &_staged_colors[span_first], span_count);
+			span_first = led;
+			span_count = 1;
+		}
+	}
+	append_span(static_cast<uint16_t>(span_first), &_staged_colors[span_first], span_count);
+}
+
+void vlpp::client::client_impl::merge_delta() {
+	for (std::size_t i = 0; i < MASK_SIZE; ++i) {
+		uint64_t staged = _staged_mask[i];
+		_staged_mask[i] = 0;
+		_known_mask[i] |= staged;
+		while (staged) {
+			std::size_t led = i * MASK_BITS + static_cast<std::size_t>(__builtin_ctzll(staged));
+			staged &= staged - 1;
+			_shadow_colors[led] = _staged_colors[led];
+		}
+	}
+}
+
+void vlpp::client::client_impl::set_async(bool async, flush_callback callback) {
+	if (_datagram_socket.is_open()) {
+		// sending a datagram never waits for the server, so there is nothing to offload:
+		_callback = async ? std::move(callback) : nullptr;
+		return;
+	}
+	if (async && external_loop()) {
+		throw std::logic_error("no asynchronous mode on an event-loop of the caller");
+	}
+	std::lock_guard<std::mutex> lock(_connection_mutex);
+	if (async) {
+		wait_for_write();
+		_callback = std::move(callback);
+		start_worker();
+	}
+	else {
+		stop_worker();
+		_callback = nullptr;
+	}
+}
+
+void vlpp::client::client_impl::set_resilient(bool resilient) {
+	if (_datagram_socket.is_open() || resilient == _resilient) {
+		// there is no connection that could be lost in udp-mode
+		return;
+	}
+	if (resilient) {
+		set_delta_mode(true);
+		_resilient = true;
+		start_monitor();
+	}
+	else {
+		stop_monitor();
+		_resilient = false;
+	}
+}
+
+bool vlpp::client::client_impl::connected() {
+	std::lock_guard<std::mutex> lock(_connection_mutex);
+	return _connected;
+}
+
+void vlpp::client::client_impl::start_monitor() {
+	_stop_monitoring = false;
+	_monitor = std::thread([this] {
+#ifdef VLPP_TRACING
+		vlpp::trace::set_thread_name("vlpp monitor");
+#endif
+		monitor();
+	});
+}
+
+void vlpp::client::client_impl::stop_monitor() {
+	if (!_monitor.joinable()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(_monitor_mutex);
+		_stop_monitoring = true;
+	}
+	_monitor_wakeup.notify_all();
+	_monitor.join();
+}
+
+bool vlpp::client::client_impl::stop_requested() {
+	std::lock_guard<std::mutex> lock(_monitor_mutex);
+	return _stop_monitoring;
+}
+
+void vlpp::client::client_impl::monitor() {
+	auto backoff = MIN_BACKOFF;
+	while (!stop_requested()) {
+		if (connected()) {
+			wait_for_hangup();
+			backoff = MIN_BACKOFF;
+			continue;
+		}
+		stream_protocol::socket socket(_event_loop);
+		if (try_reconnect(socket)) {
+			std::lock_guard<std::mutex> lock(_connection_mutex);
+			try {
+				replay(socket);
+				boost::system::error_code e;
+				_socket.close(e);
+				_socket = std::move(socket);
+				_connected = true;
+				continue;
+			}
+			catch (vlpp::connection_failure&) {
+				// try again later
+			}
+		}
+		std::unique_lock<std::mutex> lock(_monitor_mutex);
+		_monitor_wakeup.wait_for(lock, backoff, [this] { return _stop_monitoring; });
+		backoff = std::min(backoff * 2, MAX_BACKOFF);
+	}
+}
+
+void vlpp::client::client_impl::wait_for_hangup() {
+	// the server only answers the pings of sync_clock(), which reads the answers
+	// itself; only this thread replaces the socket, so the descriptor stays valid:
+	pollfd fd = {_socket.native_handle(), POLLRDHUP, 0};
+	while (true) {
+		if (stop_requested()) {
+			return;
+		}
+		int ready = ::poll(&fd, 1, 100);
+		if (ready > 0 || (ready < 0 && errno != EINTR)) {
+			break;
+		}
+		std::lock_guard<std::mutex> lock(_connection_mutex);
+		if (!_connected) {
+			// a write has failed
+			return;
+		}
+	}
+	std::lock_guard<std::mutex> lock(_connection_mutex);
+	_connected = false;
+}
+
+bool vlpp::client::client_impl::try_reconnect(stream_protocol::socket& socket) {
+	for (auto& endpoint: _endpoints) {
+		boost::system::error_code e;
+		socket.close(e);
+		socket.open(endpoint.protocol(), e);
+		if (e) {
+			continue;
+		}
+		// a blocking connect could delay the destructor for minutes, so wait
+		// for the connection ourselves:
+		socket.non_blocking(true, e);
+		if (::connect(socket.native_handle(), endpoint.data(),
+				static_cast<socklen_t>(endpoint.size())) != 0
+				&& (errno != EINPROGRESS || !wait_for_connect(socket))) {
+			continue;
+		}
+		socket.non_blocking(false, e);
+		disable_nagle(socket, endpoint);
+		std::string token;
+		{
+			std::lock_guard<std::mutex> lock(_connection_mutex);
+			token = _token;
+		}
+		send_token(socket, token, e);
+		if (!e) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool vlpp::client::client_impl::wait_for_connect(stream_protocol::socket& socket) {
+	auto deadline = std::chrono::steady_clock::now() + CONNECT_TIMEOUT;
+	pollfd fd = {socket.native_handle(), POLLOUT, 0};
+	while (std::chrono::steady_clock::now() < deadline) {
+		if (stop_requested()) {
+			return false;
+		}
+		int ready = ::poll(&fd, 1, 100);
+		if (ready < 0 && errno != EINTR) {
+			return false;
+		}
+		if (ready > 0) {
+			int error = 0;
+			socklen_t length = sizeof(error);
+			getsockopt(socket.native_handle(), SOL_SOCKET, SO_ERROR, &error, &length);
+			return error == 0;
+		}
+	}
+	return false;
+}
+
+void vlpp::client::client_impl::replay(stream_protocol::socket& socket) {
+	VLPP_TRACE_SCOPE("replay");
+	// the server has forgotten everything, so send it every known LED; nobody
+	// else uses cmd_buffer while we hold the connection-mutex, since set_led()
+	// only stages the colors in delta-mode:
+	clear_commands();
+	_replay_socket = &socket;
+	try {
+		replay_known();
+	}
+	catch (vlpp::connection_failure&) {
+		_replay_socket = nullptr;
+		throw;
+	}
+	_replay_socket = nullptr;
+	if (_worker.joinable()) {
+		socket.non_blocking(true);
+	}
+}
+
+void vlpp::client::client_impl::replay_known() {
+	// the replay is no encoding of the caller's commands, so it doesn't count as saved:
+	uint64_t encoded = _encoded_bytes.load(std::memory_order_relaxed);
+	std::size_t span_first = 0;
+	std::size_t span_count = 0;
+	for (std::size_t i = 0; i < MASK_SIZE; ++i) {
+		uint64_t known = _known_mask[i];
+		while (known) {
+			std::size_t led = i * MASK_BITS + static_cast<std::size_t>(__builtin_ctzll(known));
+			known &= known - 1;
+			if (span_count && led == span_first + span_count) {
+				++span_count;
+				continue;
+			}
+			append_span(static_cast<uint16_t>(span_first), &_shadow_colors[span_first], span_count);
+			span_first = led;
+			span_count = 1;
+		}
+	}
+	append_span(static_cast<uint16_t>(span_first), &_shadow_colors[span_first], span_count);
+	const char strobe = static_cast<char>(opcodes::STROBE);
+	append(&strobe, 1);
+	count(_requested_bytes, _encoded_bytes.load(std::memory_order_relaxed) - encoded);
+	drain();
+}
+
+void vlpp::client::client_impl::start_worker() {
+	if (_worker.joinable()) {
+		return;
+	}
+	_io_service.reset();
+	_work.reset(new io_service::work(_io_service));
+	_socket.non_blocking(true);
+	_worker = std::thread([this] {
+#ifdef VLPP_TRACING
+		vlpp::trace::set_thread_name("vlpp worker");
+#endif
+		_io_service.run();
+	});
+	if (_realtime) {
+		pin_worker();
+	}
+}
+
+void vlpp::client::client_impl::stop_worker() {
+	if (!_worker.joinable()) {
+		return;
+	}
+	// make sure that the last frame is sent before we quit:
+	std::exception_ptr error;
+	try {
+		wait_for_write();
+	}
+	catch (vlpp::connection_failure&) {
+		error = std::current_exception();
+	}
+	_work.reset();
+	_worker.join();
+	_socket.non_blocking(false);
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+void vlpp::client::client_impl::wait_for_write() {
+	VLPP_TRACE_SCOPE("wait");
+	finish_flush();
+	std::unique_lock<std::mutex> lock(_write_mutex);
+	_write_done.wait(lock, [this] { return !_write_pending; });
+	if (_write_error) {
+		auto error = _write_error;
+		_write_error = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+void vlpp::client::client_impl::write_completed(const boost::system::error_code& e,
+		bool end_of_frame) {
+	std::exception_ptr error;
+	if (e) {
+		error = std::make_exception_ptr(vlpp::connection_failure("write failed"));
+	}
+	if (end_of_frame && _callback) {
+		_callback(error);
+	}
+	{
+		std::lock_guard<std::mutex> lock(_write_mutex);
+		_write_error = error;
+		_write_pending = false;
+	}
+	_write_done.notify_all();
+}
+
+
+void vlpp::client::client_impl::send_datagrams(bool end_of_frame) {
+	VLPP_TRACE_SCOPE("send datagrams");
+	// split the frame at the boundaries of the commands, so every datagram can be
+	// decoded without the others:
+	if (!_frame_open) {
+		++_sequence;
+		_frame_open = true;
+	}
+	_datagram.resize(DATAGRAM_HEADER_SIZE);
+	std::size_t pos = 0;
+	while (pos < cmd_buffer.size()) {
+		const char* command = cmd_buffer.data() + pos;
+		auto id = [command](std::size_t offset) {
+			return static_cast<std::size_t>(static_cast<uint8_t>(command[offset]) << 8
+				| static_cast<uint8_t>(command[offset + 1]));
+		};
+		switch (static_cast<opcodes>(command[0])) {
+			case opcodes::SET_LED:
+				add_to_datagram(command, SET_LED_SIZE);
+				pos += SET_LED_SIZE;
+				break;
+			case opcodes::SET_RANGE:
+				add_to_datagram(command, SET_RANGE_SIZE);
+				pos += SET_RANGE_SIZE;
+				break;
+			case opcodes::SET_LEDS: {
+				std::size_t first = id(1);
+				std::size_t count = id(3) - first + 1;
+				const char* colors = command + 5;
+				// long spans are split into spans that fit into one datagram each:
+				const std::size_t max_count =
+					(DATAGRAM_SIZE - DATAGRAM_HEADER_SIZE - 5) / sizeof(rgba_color);
+				for (std::size_t i = 0; i < count; i += max_count) {
+					std::size_t n = std::min(max_count, count - i);
+					std::size_t span_first = first + i;
+					std::size_t span_last = span_first + n - 1;
+					std::array<char, 5> header = {{
+						static_cast<char>(opcodes::SET_LEDS),
+						static_cast<char>(span_first >> 8), static_cast<char>(span_first & 0xff),
+						static_cast<char>(span_last >> 8), static_cast<char>(span_last & 0xff)
+					}};
+					if (_datagram.size() + header.size() + n * sizeof(rgba_color) > DATAGRAM_SIZE) {
+						send_datagram(false);
+					}
+					_datagram.insert(_datagram.end(), header.begin(), header.end());
+					_datagram.insert(_datagram.end(), colors + i * sizeof(rgba_color),
+						colors + (i + n) * sizeof(rgba_color));
+				}
+				pos += 5 + count * sizeof(rgba_color);
+				break;
+			}
+			case opcodes::SET_RLE: {
+				std::size_t first = id(1);
+				std::size_t runs = id(3);
+				const char* run = command + HEADER_SIZE;
+				const std::size_t max_runs =
+					(DATAGRAM_SIZE - DATAGRAM_HEADER_SIZE - HEADER_SIZE) / RUN_SIZE;
+				for (std::size_t i = 0; i < runs; i += max_runs) {
+					std::size_t n = std::min(max_runs, runs - i);
+					std::array<char, HEADER_SIZE> header = {{
+						static_cast<char>(opcodes::SET_RLE),
+						static_cast<char>(first >> 8), static_cast<char>(first & 0xff),
+						static_cast<char>(n >> 8), static_cast<char>(n & 0xff)
+					}};
+					if (_datagram.size() + header.size() + n * RUN_SIZE > DATAGRAM_SIZE) {
+						send_datagram(false);
+					}
+					_datagram.insert(_datagram.end(), header.begin(), header.end());
+					_datagram.insert(_datagram.end(), run, run + n * RUN_SIZE);
+					// the next record starts where these runs end:
+					for (std::size_t j = 0; j < n; ++j, run += RUN_SIZE) {
+						first += static_cast<std::size_t>(static_cast<uint8_t>(run[0]) << 8
+							| static_cast<uint8_t>(run[1]));
+					}
+				}
+				pos += HEADER_SIZE + runs * RUN_SIZE;
+				break;
+			}
+			case opcodes::STROBE:
+				// the last datagram of the frame is the strobe:
+				++pos;
+				break;
+			default:
+				clear_commands();
+				throw std::logic_error("invalid command in the buffer");
+		}
+	}
+	clear_commands();
+	if (end_of_frame) {
+		_frame_open = false;
+		send_datagram(true);
+	}
+	else if (_datagram.size() > DATAGRAM_HEADER_SIZE) {
+		send_datagram(false);
+	}
+}
+
+void vlpp::client::client_impl::add_to_datagram(const char* data, std::size_t size) {
+	if (_datagram.size() + size > DATAGRAM_SIZE) {
+		send_datagram(false);
+	}
+	_datagram.insert(_datagram.end(), data, data + size);
+}
+
+void vlpp::client::client_impl::send_datagram(bool last) {
+	for (std::size_t i = 0; i < 4; ++i) {
+		_datagram[i] = static_cast<char>(_sequence >> (24 - 8 * i));
+	}
+	for (std::size_t i = 0; i < 8; ++i) {
+		_datagram[4 + i] = static_cast<char>(_digest >> (56 - 8 * i));
+	}
+	_datagram[12] = static_cast<char>(last ? vlpp::DATAGRAM_LAST : 0);
+	boost::system::error_code e;
+	count(_bytes_sent, _datagram_socket.send(boost::asio::buffer(_datagram), 0, e));
+	count(_writes, 1);
+	_datagram.resize(DATAGRAM_HEADER_SIZE);
+	// a server that is not running is no reason to stop the show, it will get
+	// the next frames once it is back:
+	if (e && e != boost::asio::error::connection_refused) {
+		throw vlpp::connection_failure("write failed");
+	}
+}
@@ -20,11 +20,29 @@
 
 #include <vector>
 #include <string>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <stdexcept>
+#include <exception>
+#include <functional>
 
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <atomic>
+#include <coroutine>
+#define VLPP_HAS_COROUTINES 1
+#endif
+
+#include "frame_view.hpp"
 #include "rgba_color.hpp"
+#include "static_frame.hpp"
+#include "stats.hpp"
+
+namespace boost {
+namespace asio {
+class io_context;
+} // namespace asio
+} // namespace boost
 
 namespace vlpp {
 
@@ -44,6 +62,57 @@ public:
 	 */
 	enum : uint16_t { DEFAULT_PORT = 7534 };
 	
+	/**
+	 * @brief the default and the smallest capacity of the command-buffer in bytes
+	 */
+	enum : std::size_t { DEFAULT_WATERMARK = 65536, MIN_WATERMARK = 64 };
+	
+	/**
+	 * @brief Callback that is invoked after an asynchronous flush has completed.
+	 *
+	 * The argument is a nullptr if the frame was sent successfully and contains
+	 * a vlpp::connection_failure otherwise.
+	 */
+	using flush_callback = std::function<void(std::exception_ptr)>;
+	
+	/**
+	 * @brief Callback that is invoked after an operation on an event-loop has completed.
+	 *
+	 * The argument is a nullptr on success and contains the exception that the
+	 * blocking version of the operation would have thrown otherwise.
+	 */
+	using completion_callback = std::function<void(std::exception_ptr)>;
+	
+	/**
+	 * @brief The results of the noexcept-interface, the methods prefixed with try_.
+	 *
+	 * Each value other than ok stands for the exception that the method without the
+	 * prefix would throw; failure stands for any other exception.
+	 */
+	enum class status {
+		ok,
+		uninitialized,
+		invalid_argument,
+		connection_failure,
+		failure
+	};
+	
+	/**
+	 * @brief The result of sync_clock().
+	 */
+	struct clock_estimate {
+		/**
+		 * @brief the monotonic clock of the server minus std::chrono::steady_clock
+		 */
+		std::chrono::nanoseconds offset;
+		
+		/**
+		 * @brief the round-trip-time of the ping the offset was taken from; the
+		 *        offset is off by at most half of it
+		 */
+		std::chrono::nanoseconds round_trip;
+	};
+	
 	/**
 	 * @brief the default constructor.
 	 *
@@ -57,9 +126,11 @@ public:
 	/**
 	 * @brief Constructs an instance, connects to the specified server and authenticates there.
 	 * @param server the servername; this might be an ip-address or an hostname,
-	 *               eg "192.168.23.44" or "example.com"
+	 *               eg "192.168.23.44" or "example.com", or the path of a local
+	 *               unix-domain-socket prefixed with "unix:", eg "unix:/run/vaporlight.sock";
+	 *               prefix a hostname with "udp:" to use udp-mode (see flush())
 	 * @param token the authentication-token
-	 * @param port the server-port
+	 * @param port the server-port; ignored for unix-domain-sockets
 	 * @throws std::invalid_argument if the token has an invalid size
 	 * @throws vlpp::connection_failure if no connection could be created or a write fails
 	 */
@@ -96,13 +167,344 @@ public:
 	 */
 	void set_leds(const std::vector<uint16_t> &led_ids, const rgba_color &col);
 	
+	/**
+	 * @brief Sets all LEDs with an ID in [first, last] to a specific color.
+	 *
+	 * This is sent as a single command, regardless of the size of the range.
+	 * @param first the ID of the first LED
+	 * @param last the ID of the last LED
+	 * @param col the new color of the LEDs
+	 * @throws std::invalid_argument if last is smaller than first
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_led_range(uint16_t first, uint16_t last, const rgba_color &col);
+	
+	/**
+	 * @brief Sets consecutive LEDs to the colors of an array.
+	 *
+	 * The colors are sent as a single command with one packed RGBA-quadruple per LED.
+	 * @param first the ID of the LED that gets the first color
+	 * @param colors the colors; the LED first+i gets colors[i]
+	 * @param count the number of colors
+	 * @throws std::invalid_argument if the IDs would exceed the largest LED-ID
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_leds(uint16_t first, const rgba_color *colors, std::size_t count);
+	
+	/**
+	 * @brief Sets consecutive LEDs to the colors of a range.
+	 * @param first the ID of the LED that gets the first color
+	 * @param begin iterator to the first color
+	 * @param end iterator behind the last color
+	 * @throws std::invalid_argument if the IDs would exceed the largest LED-ID
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	template<typename Iterator>
+	void set_leds(uint16_t first, Iterator begin, Iterator end);
+	
 	/**
 	 * @brief execute the sent commands
-	 * @throws std::runtime_error if the write fails
+	 *
+	 * In asynchronous mode this only waits until the previous frame has been
+	 * sent and hands the current one to the worker-thread.
+	 *
+	 * In udp-mode the frame is sent as one or more self-contained datagrams
+	 * (see vlpp::DATAGRAM_SIZE) that are never resent: a lost datagram only loses its
+	 * part of the frame and doesn't delay the following frames, and the server drops
+	 * datagrams that arrive after newer ones. Since lost changes are never repeated,
+	 * call invalidate() regularly if you combine udp-mode with delta-mode. Asynchronous
+	 * mode only enables the callback, as sending a datagram never waits for the server.
+	 * @throws std::runtime_error if the write (or the last asynchronous write) fails
 	 * @throws vlpp::uninitialized_error if this is not initialized correctly
 	 */
 	void flush();
 	
+	/**
+	 * @brief Executes the sent commands at a given time.
+	 *
+	 * This behaves like flush(), but the server executes the frame when its clock
+	 * reaches the given time, converted with the offset of the last sync_clock(); a
+	 * time that has passed when the frame arrives is executed right away. Until then the
+	 * server holds back the following commands, so the next frame may be sent early.
+	 * Clients of different servers can use this to execute their frames at the same
+	 * moment (see vlpp::cluster_client).
+	 * @param when the moment of the execution on the local clock
+	 * @throws std::logic_error in udp-mode or if sync_clock() was never called
+	 * @throws std::runtime_error if the write (or the last asynchronous write) fails
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void flush_at(std::chrono::steady_clock::time_point when);
+	
+	/**
+	 * @brief Estimates the offset between the clock of the server and the local one.
+	 *
+	 * The client sends some pings, each with the local time, and the server answers
+	 * with its own time; like NTP the offset is taken from the ping with the shortest
+	 * round-trip, assuming that it took equally long in both directions. The result is
+	 * used by flush_at(). The clocks drift apart, so this should be repeated from time
+	 * to time; the commands that were set so far are not affected.
+	 * @param samples the number of pings, at least one
+	 * @return the offset and the round-trip-time of the best ping
+	 * @throws std::invalid_argument if samples is zero
+	 * @throws std::logic_error in udp-mode
+	 * @throws vlpp::connection_failure if the server doesn't answer within a second
+	 *         or the connection fails
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	clock_estimate sync_clock(unsigned samples = 8);
+	
+	/**
+	 * @brief Sends the commands that were set so far without executing them.
+	 *
+	 * The server keeps them until the strobe of the next flush(), which then only has
+	 * to send the commands that were set in between, so the frame is executed with
+	 * a minimal delay. This lets several clients execute their frames almost at the
+	 * same time (see vlpp::cluster_client). In delta-mode the changes are compared
+	 * and sent, in asynchronous mode they are only handed to the worker-thread.
+	 *
+	 * A failed write is thrown by the next flush(), as if the commands had been
+	 * sent by it.
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void send();
+	
+	/**
+	 * @brief The noexcept-interface for a real-time render-thread.
+	 *
+	 * These behave like the methods without the prefix but report errors as a status
+	 * instead of throwing. The buffers are allocated by the constructor (and by
+	 * set_watermark() and set_delta_mode()), so once the first frame has been sent,
+	 * building and flushing a frame doesn't allocate memory, unless an error occurs.
+	 * @return status::ok on success
+	 */
+	status try_set_led(uint16_t led_id, const rgba_color &col) noexcept;
+	
+	/**
+	 * @copydoc try_set_led()
+	 */
+	status try_set_led_range(uint16_t first, uint16_t last, const rgba_color &col) noexcept;
+	
+	/**
+	 * @copydoc try_set_led()
+	 */
+	status try_set_leds(uint16_t first, const rgba_color *colors, std::size_t count) noexcept;
+	
+	/**
+	 * @copydoc try_set_led()
+	 */
+	status try_flush() noexcept;
+	
+	/**
+	 * @brief Connects to a server on an event-loop of the caller and authenticates there.
+	 *
+	 * Unlike the constructor this doesn't block: resolving, connecting and sending the
+	 * token are operations of the io_service, so many clients can share the thread that
+	 * runs it, and async_flush() sends the frames the same way. Such a client must only
+	 * be used by the thread that runs the io_service, and asynchronous mode is not
+	 * available. A previous connection of this client is closed.
+	 * @param io_service the event-loop, it must outlive the client
+	 * @param server the servername, see client()
+	 * @param token the authentication-token
+	 * @param port the server-port; ignored for unix-domain-sockets
+	 * @param callback will be called by the io_service once the client is connected
+	 *        or has failed with a vlpp::connection_failure; the client must not be used
+	 *        before
+	 * @throws std::invalid_argument if the token has an invalid size
+	 */
+	void async_connect(boost::asio::io_context& io_service, const std::string &server,
+		const std::string &token, uint16_t port, completion_callback callback);
+	
+	/**
+	 * @brief Executes the sent commands without blocking the event-loop.
+	 *
+	 * For clients that were connected by async_connect() the frame is written as far
+	 * as the socket accepts it, the rest is written by the io_service whenever the
+	 * socket is ready again; the callback is called by the io_service afterwards.
+	 * Commands for the next frame may be set in the meantime, but only one frame may be
+	 * in flight: the blocking methods complete it first. All other clients, and
+	 * clients in udp- or resilient mode, behave like flush() and call the callback
+	 * before this returns.
+	 * @param callback will be called after the frame has been sent
+	 * @throws std::logic_error if the previous frame is still in flight
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void async_flush(completion_callback callback);
+	
+#ifdef VLPP_HAS_COROUTINES
+	class operation;
+	
+	/**
+	 * @brief The awaitable version of async_connect(), for C++20-coroutines.
+	 *
+	 * The coroutine is resumed by the io_service; the errors are thrown by co_await.
+	 */
+	operation async_connect(boost::asio::io_context& io_service, const std::string &server,
+		const std::string &token, uint16_t port = DEFAULT_PORT);
+	
+	/**
+	 * @brief The awaitable version of async_flush(), for C++20-coroutines.
+	 */
+	operation async_flush();
+#endif
+	
+	/**
+	 * @brief Sends a frame from memory of the caller and executes it.
+	 *
+	 * The commands that were set before are sent first, then a SET_LEDS-header for
+	 * every span, the colors and a strobe; all of them are passed to the kernel as
+	 * a single gathered write, so the colors are never copied in user-space. This
+	 * returns after the whole frame is written, even in asynchronous mode, since the
+	 * colors belong to the caller.
+	 *
+	 * In delta-mode and in udp-mode the colors have to be compared or split, so they
+	 * are copied like by set_leds() and flush().
+	 * @param frame the frame
+	 * @throws vlpp::connection_failure if the write (or the last asynchronous write) fails
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void submit(const frame_view& frame);
+	
+	/**
+	 * @brief Sends a frame with a layout that is known at compile time and executes it.
+	 *
+	 * The frame is already encoded, so it is written as it is, after the commands that
+	 * were set before; like submit(const frame_view&) this returns after the whole frame
+	 * is written. In delta-mode, with compaction and in udp-mode the LEDs are set one by
+	 * one and flushed instead.
+	 * @param frame the frame
+	 * @throws vlpp::connection_failure if the write (or the last asynchronous write) fails
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	template<uint16_t... Ids>
+	void submit(const static_frame<Ids...>& frame);
+	
+	/**
+	 * @brief Enables or disables asynchronous flushing.
+	 *
+	 * In asynchronous mode flush() never blocks on the socket: whatever the kernel
+	 * doesn't accept right away is handed to a worker-thread in a second buffer,
+	 * so the caller can start building the next frame right away. At most one
+	 * frame is in flight at any time.
+	 *
+	 * If a write fails, the callback is called with the error and the next call of
+	 * flush() or authenticate() throws it.
+	 * @param async true to enable asynchronous flushing, false to go back to blocking writes
+	 * @param callback will be called after every frame, either from within flush() or
+	 *        from the worker-thread; it must not call any methods of this client
+	 * @throws vlpp::connection_failure if disabling async mode reveals a failed write
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_async(bool async, flush_callback callback = nullptr);
+	
+	/**
+	 * @brief Enables or disables delta-transmission.
+	 *
+	 * In delta-mode the client keeps a copy of the last color that was flushed for
+	 * every LED; set_led() only stages the new color and flush() sends just the LEDs
+	 * whose color differs from that copy.
+	 *
+	 * Disabling delta-mode keeps the staged changes, they will be sent by the next
+	 * flush().
+	 * @param delta true to enable delta-mode
+	 * @throws std::logic_error if delta-mode is disabled in resilient mode
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_delta_mode(bool delta);
+	
+	/**
+	 * @brief Enables or disables last-write-wins compaction.
+	 *
+	 * With compaction set_led() and friends only record the new color in a dense
+	 * per-LED slot (plus a bitmap of the touched slots) and flush() sends every touched
+	 * LED exactly once, with the color it was set to last; consecutive LEDs are
+	 * merged into ranges. Unlike delta-mode every touched LED is sent, even if its
+	 * color didn't change since the last frame. The cost is O(1) per write and a
+	 * scan of the 1024-word bitmap per flush().
+	 *
+	 * In delta-mode writes are compacted anyway; disabling compaction keeps the
+	 * staged changes, they will be sent by the next flush().
+	 * @param compact true to enable compaction
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_compaction(bool compact);
+	
+	/**
+	 * @brief Forgets which colors the server already knows.
+	 *
+	 * The next flush() will send every LED that was ever set in delta-mode again,
+	 * which is necessary after a reconnect or a failed flush(). Without delta-mode
+	 * this does nothing.
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void invalidate();
+	
+	/**
+	 * @brief Enables or disables resilient mode.
+	 *
+	 * In resilient mode a lost connection doesn't make flush() or authenticate()
+	 * throw: a background-thread reconnects with an exponential backoff (100ms up
+	 * to 5s) and authenticates with the last token. In the meantime flush() only
+	 * keeps the latest color of every LED, so the memory doesn't grow, and after the
+	 * reconnect that state is replayed to the server at once.
+	 *
+	 * The latest state is tracked by delta-mode, so enabling resilient mode also
+	 * enables delta-mode. Resilient mode has no effect in udp-mode.
+	 * @param resilient true to enable resilient mode
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_resilient(bool resilient);
+	
+	/**
+	 * @brief Checks whether the client is connected to the server.
+	 * @return false if resilient mode is trying to reconnect, true otherwise
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	bool connected();
+	
+	/**
+	 * @brief Sets the capacity of the command-buffer.
+	 *
+	 * The buffer is allocated once and doesn't grow while a frame is built: if a
+	 * command doesn't fit anymore, everything before it is sent right away without
+	 * a strobe, so the memory stays constant and the server already receives the
+	 * beginning of a large frame while the rest is still built. If sending such a part
+	 * fails, the error is thrown by the next flush(). Asynchronous mode uses two
+	 * buffers of this size.
+	 * @param bytes the capacity, at least MIN_WATERMARK
+	 * @throws std::invalid_argument if the capacity is too small
+	 * @throws vlpp::connection_failure if a pending write fails
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_watermark(std::size_t bytes);
+	
+	/**
+	 * @brief Enables or disables realtime-mode.
+	 *
+	 * Realtime-mode locks all current and future memory of the process into RAM
+	 * (mlockall()), so the render-thread never waits for a page-fault, and pins the
+	 * worker-thread of asynchronous mode to one CPU. In synchronous mode the frames are
+	 * sent by the thread that calls flush(), which isn't touched. Disabling it unlocks
+	 * the memory of the whole process again and lets the worker run on the CPUs of the
+	 * calling thread.
+	 * @param realtime true to enable realtime-mode
+	 * @param cpu the CPU that the worker-thread is pinned to
+	 * @throws std::invalid_argument if the CPU doesn't exist
+	 * @throws std::system_error if the memory can't be locked (see RLIMIT_MEMLOCK)
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_realtime(bool realtime, unsigned cpu = 0);
+	
+	/**
+	 * @brief Takes a snapshot of the statistics.
+	 *
+	 * Unlike all other methods this may be called from any thread while the client is
+	 * used; the counters are updated without locks, so this never blocks the
+	 * render-thread.
+	 * @return the statistics since the construction of the client
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	client_stats stats() const;
+	
 protected:
 	/**
 	 * @brief Gives you direct access to the internal buffer. NEVER use this, unless
@@ -113,6 +515,8 @@ protected:
 	std::vector<char> &access_buffer();
 	
 private:
+	void submit_set_leds(const char* commands, std::size_t count);
+	
 	// we are using the pimpl-idiom to decrease the
 	// compiletime and dependencies for users of this class:
 	class client_impl;
@@ -121,6 +525,88 @@ private:
 	std::shared_ptr<client_impl> _impl;
 };
 
+#ifdef VLPP_HAS_COROUTINES
+/**
+ * @brief The result of the awaitable operations of vlpp::client.
+ *
+ * It resumes the awaiting coroutine from the completion-callback of the operation,
+ * so it works with any coroutine-type that accepts foreign awaitables. Operations
+ * that call back before they return (see async_flush()) don't suspend at all.
+ */
+class client::operation {
+public:
+	bool await_ready() const noexcept {
+		return false;
+	}
+	
+	bool await_suspend(std::coroutine_handle<> coroutine) {
+		// whoever comes second of the callback and the return of _start() continues the
+		// coroutine; resuming it from within _start() would destroy this while it runs:
+		_start([this, coroutine](std::exception_ptr error) {
+			_error = error;
+			if (_completed.exchange(true)) {
+				coroutine.resume();
+			}
+		});
+		return !_completed.exchange(true);
+	}
+	
+	void await_resume() const {
+		if (_error) {
+			std::rethrow_exception(_error);
+		}
+	}
+	
+private:
+	friend class client;
+	
+	explicit operation(std::function<void(completion_callback)> start):
+		_start(std::move(start)) {}
+	
+	std::function<void(completion_callback)> _start;
+	std::exception_ptr _error;
+	std::atomic<bool> _completed{false};
+};
+
+inline client::operation client::async_connect(boost::asio::io_context& io_service,
+		const std::string &server, const std::string &token, uint16_t port) {
+	return operation([this, &io_service, server, token, port](completion_callback callback) {
+		async_connect(io_service, server, token, port, std::move(callback));
+	});
+}
+
+inline client::operation client::async_flush() {
+	return operation([this](completion_callback callback) {
+		async_flush(std::move(callback));
+	});
+}
+#endif
+
+template<uint16_t... Ids>
+void client::submit(const static_frame<Ids...>& frame) {
+	submit_set_leds(frame.data(), frame.size());
+}
+
+template<typename Iterator>
+void client::set_leds(uint16_t first, Iterator begin, Iterator end) {
+	// copy the colors into a packed array, one chunk at a time:
+	enum { CHUNK_SIZE = 1024 };
+	rgba_color chunk[CHUNK_SIZE];
+	std::size_t next = first;
+	std::size_t count = 0;
+	while (begin != end) {
+		chunk[count++] = *begin++;
+		if (count == CHUNK_SIZE || begin == end) {
+			if (next > UINT16_MAX) {
+				throw std::invalid_argument("invalid range");
+			}
+			set_leds(static_cast<uint16_t>(next), chunk, count);
+			next += count;
+			count = 0;
+		}
+	}
+}
+
 /**
  * @brief Exception that will be thrown if the connection fails
  */
@@ -0,0 +1,316 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cluster_client.hpp"
+#include "protocol.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+//pimpl-class (private members of cluster_client):
+class vlpp::cluster_client::cluster_client_impl {
+	public:
+		cluster_client_impl(std::vector<shard> shards, const std::string& token);
+		~cluster_client_impl();
+		void set_led(uint16_t led, const rgba_color& col) {
+			uint16_t index = _routes[led];
+			if (index != NO_SHARD) {
+				_clients[index].set_led(led, col);
+				_dirty[index] = true;
+			}
+		}
+		void set_led_range(uint16_t first, uint16_t last, const rgba_color& col);
+		void set_leds(uint16_t first, const rgba_color* colors, std::size_t count);
+		void flush();
+		std::vector<client::clock_estimate> sync_clocks(unsigned samples);
+		void set_presentation_delay(std::chrono::microseconds delay) {
+			_presentation_delay = delay;
+		}
+		void set_resilient(bool resilient);
+		
+	private:
+		enum : uint16_t { NO_SHARD = UINT16_MAX };
+		void run_sender(std::size_t index);
+		std::exception_ptr send(std::size_t index);
+		
+		// sorted by their first LED:
+		std::vector<shard> _shards;
+		std::vector<vlpp::client> _clients;
+		// the index of the shard of every LED:
+		std::vector<uint16_t> _routes;
+		// whether a shard got commands since the last flush:
+		std::vector<char> _dirty;
+		std::chrono::microseconds _presentation_delay{0};
+		
+		// the senders of all shards but the first, which flush() sends itself; they
+		// send whenever the generation changes and count the pending senders down:
+		std::vector<std::thread> _senders;
+		std::mutex _mutex;
+		std::condition_variable _start;
+		std::condition_variable _done;
+		uint64_t _generation = 0;
+		std::size_t _pending = 0;
+		bool _stop = false;
+		std::vector<std::exception_ptr> _errors;
+};
+
+///////////
+
+vlpp::cluster_client::cluster_client(const std::vector<shard>& shards, const std::string& token):
+	_impl(std::make_shared<cluster_client_impl>(shards, token)) {
+}
+
+void vlpp::cluster_client::set_led(uint16_t led_id, const rgba_color &col) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::cluster_client");
+	}
+	_impl->set_led(led_id, col);
+}
+
+void vlpp::cluster_client::set_leds(const std::vector<uint16_t> &led_ids, const rgba_color &col) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::cluster_client");
+	}
+	// the clients merge consecutive IDs of the same color into ranges:
+	for (auto led: led_ids) {
+		_impl->set_led(led, col);
+	}
+}
+
+void vlpp::cluster_client::set_led_range(uint16_t first, uint16_t last, const rgba_color &col) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::cluster_client");
+	}
+	if (last < first) {
+		throw std::invalid_argument("invalid range");
+	}
+	_impl->set_led_range(first, last, col);
+}
+
+void vlpp::cluster_client::set_leds(uint16_t first, const rgba_color *colors, std::size_t count) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::cluster_client");
+	}
+	if (count > vlpp::LED_COUNT - first) {
+		throw std::invalid_argument("invalid range");
+	}
+	_impl->set_leds(first, colors, count);
+}
+
+void vlpp::cluster_client::flush() {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::cluster_client");
+	}
+	_impl->flush();
+}
+
+std::vector<vlpp::client::clock_estimate> vlpp::cluster_client::sync_clocks(unsigned samples) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::cluster_client");
+	}
+	if (samples == 0) {
+		throw std::invalid_argument("no samples");
+	}
+	return _impl->sync_clocks(samples);
+}
+
+void vlpp::cluster_client::set_presentation_delay(std::chrono::microseconds delay) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::cluster_client");
+	}
+	if (delay.count() < 0) {
+		throw std::invalid_argument("negative delay");
+	}
+	_impl->set_presentation_delay(delay);
+}
+
+void vlpp::cluster_client::set_resilient(bool resilient) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::cluster_client");
+	}
+	_impl->set_resilient(resilient);
+}
+
+///////// now: the private stuff
+
+vlpp::cluster_client::cluster_client_impl::cluster_client_impl(std::vector<shard> shards,
+		const std::string& token):
+	_shards(std::move(shards)),
+	_routes(vlpp::LED_COUNT, NO_SHARD) {
+	if (_shards.empty() || _shards.size() >= NO_SHARD) {
+		throw std::invalid_argument("invalid number of shards");
+	}
+	std::sort(_shards.begin(), _shards.end(), [](const shard& lhs, const shard& rhs) {
+		return lhs.first < rhs.first;
+	});
+	for (std::size_t i = 0; i < _shards.size(); ++i) {
+		if (_shards[i].last < _shards[i].first) {
+			throw std::invalid_argument("invalid range");
+		}
+		if (i > 0 && _shards[i].first <= _shards[i - 1].last) {
+			throw std::invalid_argument("overlapping shards");
+		}
+		std::fill(_routes.begin() + _shards[i].first, _routes.begin() + _shards[i].last + 1,
+			static_cast<uint16_t>(i));
+	}
+	for (auto& s: _shards) {
+		_clients.emplace_back(s.server, token, s.port);
+	}
+	_dirty.assign(_shards.size(), false);
+	_errors.resize(_shards.size());
+	for (std::size_t i = 1; i < _shards.size(); ++i) {
+		_senders.emplace_back([this, i] {
+			run_sender(i);
+		});
+	}
+}
+
+vlpp::cluster_client::cluster_client_impl::~cluster_client_impl() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_start.notify_all();
+	for (auto& sender: _senders) {
+		sender.join();
+	}
+}
+
+void vlpp::cluster_client::cluster_client_impl::set_led_range(uint16_t first, uint16_t last,
+		const rgba_color& col) {
+	for (std::size_t i = 0; i < _shards.size(); ++i) {
+		uint16_t begin = std::max(first, _shards[i].first);
+		uint16_t end = std::min(last, _shards[i].last);
+		if (begin <= end) {
+			_clients[i].set_led_range(begin, end, col);
+			_dirty[i] = true;
+		}
+	}
+}
+
+void vlpp::cluster_client::cluster_client_impl::set_leds(uint16_t first,
+		const rgba_color* colors, std::size_t count) {
+	if (count == 0) {
+		return;
+	}
+	std::size_t last = first + count - 1;
+	for (std::size_t i = 0; i < _shards.size(); ++i) {
+		std::size_t begin = std::max<std::size_t>(first, _shards[i].first);
+		std::size_t end = std::min<std::size_t>(last, _shards[i].last);
+		if (begin <= end) {
+			_clients[i].set_leds(static_cast<uint16_t>(begin), colors + (begin - first),
+				end - begin + 1);
+			_dirty[i] = true;
+		}
+	}
+}
+
+void vlpp::cluster_client::cluster_client_impl::flush() {
+	VLPP_TRACE_SCOPE("cluster flush");
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		++_generation;
+		_pending = _senders.size();
+	}
+	_start.notify_all();
+	_errors[0] = send(0);
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_done.wait(lock, [this] { return _pending == 0; });
+	}
+	// all commands have arrived, now the strobes follow as fast as possible:
+	bool timed = _presentation_delay.count() != 0;
+	auto when = std::chrono::steady_clock::now() + _presentation_delay;
+	std::exception_ptr error;
+	for (std::size_t i = 0; i < _clients.size(); ++i) {
+		if (_dirty[i] && !_errors[i]) {
+			try {
+				if (timed) {
+					_clients[i].flush_at(when);
+				}
+				else {
+					_clients[i].flush();
+				}
+			}
+			catch (std::exception&) {
+				_errors[i] = std::current_exception();
+			}
+		}
+		_dirty[i] = false;
+		if (_errors[i] && !error) {
+			error = _errors[i];
+		}
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+std::vector<vlpp::client::clock_estimate>
+vlpp::cluster_client::cluster_client_impl::sync_clocks(unsigned samples) {
+	std::vector<client::clock_estimate> estimates;
+	for (auto& client: _clients) {
+		estimates.push_back(client.sync_clock(samples));
+	}
+	return estimates;
+}
+
+void vlpp::cluster_client::cluster_client_impl::set_resilient(bool resilient) {
+	for (auto& client: _clients) {
+		client.set_resilient(resilient);
+	}
+}
+
+void vlpp::cluster_client::cluster_client_impl::run_sender(std::size_t index) {
+#ifdef VLPP_TRACING
+	vlpp::trace::set_thread_name("vlpp shard sender");
+#endif
+	uint64_t generation = 0;
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true) {
+		_start.wait(lock, [&] { return _stop || _generation != generation; });
+		if (_stop) {
+			return;
+		}
+		generation = _generation;
+		lock.unlock();
+		auto error = send(index);
+		lock.lock();
+		_errors[index] = error;
+		if (--_pending == 0) {
+			_done.notify_one();
+		}
+	}
+}
+
+std::exception_ptr vlpp::cluster_client::cluster_client_impl::send(std::size_t index) {
+	if (!_dirty[index]) {
+		return nullptr;
+	}
+	try {
+		_clients[index].send();
+	}
+	catch (std::exception&) {
+		return std::current_exception();
+	}
+	return nullptr;
+}
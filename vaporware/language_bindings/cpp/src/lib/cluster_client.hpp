@@ -0,0 +1,188 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CLUSTER_CLIENT_HPP
+#define CLUSTER_CLIENT_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "client.hpp"
+#include "rgba_color.hpp"
+
+namespace vlpp {
+
+/**
+ * @brief A client for rigs that are driven by several servers.
+ *
+ * Every server (shard) owns a range of LED-IDs; the commands are routed to the
+ * shard that owns the LEDs, LEDs that no shard owns are ignored. flush() sends
+ * the commands of all shards in parallel, one thread per shard, and strobes them
+ * right after each other once all commands have arrived, so the frame takes as
+ * long as the slowest shard and the shards execute it almost at the same time.
+ * With a presentation-delay the strobes carry a common time instead, so differences
+ * in the latencies of the shards don't matter either.
+ *
+ * Note that using this class is NOT threadsafe.
+ */
+class cluster_client {
+public:
+	/**
+	 * @brief A server and the LEDs it owns.
+	 */
+	struct shard {
+		/**
+		 * @brief the first LED-ID of the shard
+		 */
+		uint16_t first;
+		
+		/**
+		 * @brief the last LED-ID of the shard
+		 */
+		uint16_t last;
+		
+		/**
+		 * @brief the servername, see vlpp::client::client()
+		 */
+		std::string server;
+		
+		/**
+		 * @brief the server-port
+		 */
+		uint16_t port;
+	};
+	
+	/**
+	 * @brief the default constructor.
+	 *
+	 * Note that this is not properly constructed afterwards, so any
+	 * attempt of using it will result in a vlpp::uninitialized_error
+	 * beeing thrown.
+	 */
+	cluster_client() = default;
+	
+	/**
+	 * @brief Connects to all shards and authenticates there.
+	 * @param shards the routing-table; the ranges must not overlap
+	 * @param token the authentication-token, which must be valid on all shards
+	 * @throws std::invalid_argument if there are no shards, a range is invalid,
+	 *         two ranges overlap or the token has an invalid size
+	 * @throws vlpp::connection_failure if a connection could not be created
+	 */
+	cluster_client(const std::vector<shard>& shards, const std::string& token);
+	
+	cluster_client(const cluster_client&) = delete;
+	cluster_client(cluster_client&&) = default;
+	
+	cluster_client &operator=(const cluster_client&) = delete;
+	cluster_client &operator=(cluster_client&&) = default;
+	
+	/**
+	 * @brief Sets a rgb-LED to a specific rgba-color.
+	 * @param led_id the ID of the led
+	 * @param col the new color of the LED
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_led(uint16_t led_id, const rgba_color &col);
+	
+	/**
+	 * @brief Sets a list of LEDs to a specific color.
+	 * @param led_ids the IDs of the LEDs
+	 * @param col the new color of the LEDs
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_leds(const std::vector<uint16_t> &led_ids, const rgba_color &col);
+	
+	/**
+	 * @brief Sets all LEDs with an ID in [first, last] to a specific color.
+	 *
+	 * Every shard gets a single command for its part of the range.
+	 * @param first the ID of the first LED
+	 * @param last the ID of the last LED
+	 * @param col the new color of the LEDs
+	 * @throws std::invalid_argument if last is smaller than first
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_led_range(uint16_t first, uint16_t last, const rgba_color &col);
+	
+	/**
+	 * @brief Sets consecutive LEDs to the colors of an array.
+	 * @param first the ID of the LED that gets the first color
+	 * @param colors the colors; the LED first+i gets colors[i]
+	 * @param count the number of colors
+	 * @throws std::invalid_argument if the IDs would exceed the largest LED-ID
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_leds(uint16_t first, const rgba_color *colors, std::size_t count);
+	
+	/**
+	 * @brief Executes the commands on all shards.
+	 *
+	 * Only the shards that got commands since the last flush() are strobed. If some
+	 * shards fail, the others still execute the frame and the first error is thrown.
+	 * With a presentation-delay all shards execute the frame at the moment that lies
+	 * that long after all commands have been sent.
+	 * @throws std::logic_error if there is a presentation-delay but sync_clocks() was
+	 *         never called
+	 * @throws vlpp::connection_failure if a write fails
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void flush();
+	
+	/**
+	 * @brief Estimates the offsets of the clocks of all shards.
+	 * @param samples the number of pings per shard, at least one
+	 * @return the estimates in the order of the first LEDs of the shards
+	 * @throws std::invalid_argument if samples is zero
+	 * @throws vlpp::connection_failure if a shard doesn't answer
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 * @see vlpp::client::sync_clock()
+	 */
+	std::vector<client::clock_estimate> sync_clocks(unsigned samples = 8);
+	
+	/**
+	 * @brief Sets the time between sending the last command and executing a frame.
+	 *
+	 * The delay has to cover the time the strobes need to reach the slowest shard and
+	 * the error of the clock-offsets, a frame that arrives too late is executed as
+	 * soon as it arrives. Since the clocks drift apart, call sync_clocks() regularly.
+	 * @param delay the delay, zero to strobe the shards right away
+	 * @throws std::invalid_argument if the delay is negative
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_presentation_delay(std::chrono::microseconds delay);
+	
+	/**
+	 * @brief Enables or disables resilient mode for all shards.
+	 * @param resilient true to reconnect in the background instead of failing
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 * @see vlpp::client::set_resilient()
+	 */
+	void set_resilient(bool resilient);
+	
+private:
+	class cluster_client_impl;
+	// see vlpp::client for the reason of the shared_ptr:
+	std::shared_ptr<cluster_client_impl> _impl;
+};
+
+} // namespace vlpp
+
+#endif // CLUSTER_CLIENT_HPP
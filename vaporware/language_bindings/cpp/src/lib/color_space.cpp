@@ -0,0 +1,524 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "color_space.hpp"
+#include "blend.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+using vlpp::rgba_color;
+using vlpp::hsv_color;
+using vlpp::hsl_color;
+using vlpp::lab_color;
+using vlpp::oklab_color;
+
+const char* const NAMES[] = {"rgb", "hsv", "hsl", "lab", "oklab"};
+
+// the transfer-function of sRGB in both directions; linear values are looked up with
+// ENCODE_BITS bits, which is enough to give every 8-bit value back unchanged:
+const unsigned ENCODE_BITS = 12;
+const std::size_t ENCODE_SIZE = std::size_t(1) << ENCODE_BITS;
+const float ENCODE_SCALE = ENCODE_SIZE - 1;
+
+struct gamma_tables {
+	std::array<float, 256> decode;
+	std::array<uint8_t, ENCODE_SIZE> encode;
+};
+
+const gamma_tables& gamma() {
+	static const gamma_tables tables = [] {
+		gamma_tables result;
+		for (std::size_t i = 0; i < result.decode.size(); ++i) {
+			double c = i / 255.0;
+			result.decode[i] = static_cast<float>(c <= 0.04045 ? c / 12.92
+				: std::pow((c + 0.055) / 1.055, 2.4));
+		}
+		for (std::size_t i = 0; i < ENCODE_SIZE; ++i) {
+			double l = i / static_cast<double>(ENCODE_SCALE);
+			double c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1 / 2.4) - 0.055;
+			result.encode[i] = static_cast<uint8_t>(std::lround(c * 255));
+		}
+		return result;
+	}();
+	return tables;
+}
+
+uint8_t encode(const gamma_tables& tables, float linear) {
+	linear = std::min(1.0f, std::max(0.0f, linear));
+	return tables.encode[static_cast<std::size_t>(linear * ENCODE_SCALE + 0.5f)];
+}
+
+uint8_t to_byte(float value) {
+	return static_cast<uint8_t>(std::min(1.0f, std::max(0.0f, value)) * 255 + 0.5f);
+}
+
+float wrap_hue(float hue) {
+	if (hue >= 0 && hue < 360) {
+		return hue;
+	}
+	hue = std::fmod(hue, 360.0f);
+	return hue < 0 ? hue + 360 : hue;
+}
+
+/*
+ * the hue of a color in degrees from its largest channel and the difference to the
+ * smallest one
+ */
+float hue_of(float r, float g, float b, float max, float delta) {
+	if (delta <= 0) {
+		return 0;
+	}
+	if (max == r) {
+		return 60 * ((g - b) / delta + (g < b ? 6 : 0));
+	}
+	if (max == g) {
+		return 60 * ((b - r) / delta + 2);
+	}
+	return 60 * ((r - g) / delta + 4);
+}
+
+/*
+ * the color with a hue, the difference between the largest and the smallest channel
+ * (chroma) and the smallest channel
+ */
+rgba_color from_hue(float hue, float chroma, float min) {
+	float position = wrap_hue(hue) / 60;
+	int sector = static_cast<int>(position);
+	// the channel between the largest and the smallest one rises in even sectors:
+	float rise = position - static_cast<float>(sector);
+	float x = chroma * (sector % 2 ? 1 - rise : rise);
+	float r = 0, g = 0, b = 0;
+	switch (sector) {
+		case 0: r = chroma; g = x; break;
+		case 1: r = x; g = chroma; break;
+		case 2: g = chroma; b = x; break;
+		case 3: g = x; b = chroma; break;
+		case 4: r = x; b = chroma; break;
+		default: r = chroma; b = x;
+	}
+	return rgba_color(to_byte(r + min), to_byte(g + min), to_byte(b + min));
+}
+
+/*
+ * The cube-root for Lab and OKLab: an estimate from the bits of the float and two steps of
+ * Newton's method, which gives about six correct digits. Only non-negative values
+ * occur, and it is much faster than std::cbrt().
+ */
+float cube_root(float x) {
+	if (x <= 0) {
+		return 0;
+	}
+	uint32_t bits;
+	std::memcpy(&bits, &x, sizeof(bits));
+	bits = bits / 3 + 0x2a514067;
+	float y;
+	std::memcpy(&y, &bits, sizeof(y));
+	y = (2 * y + x / (y * y)) / 3;
+	return (2 * y + x / (y * y)) / 3;
+}
+
+// CIELab with the white-point D65:
+const float WHITE_X = 0.95047f;
+const float WHITE_Z = 1.08883f;
+const float LAB_DELTA = 6.0f / 29;
+
+float lab_f(float t) {
+	return t > LAB_DELTA * LAB_DELTA * LAB_DELTA ? cube_root(t)
+		: t / (3 * LAB_DELTA * LAB_DELTA) + 4.0f / 29;
+}
+
+float lab_f_inverse(float f) {
+	return f > LAB_DELTA ? f * f * f : 3 * LAB_DELTA * LAB_DELTA * (f - 4.0f / 29);
+}
+
+oklab_color oklab_of(const gamma_tables& tables, const rgba_color& col) {
+	float r = tables.decode[col.red];
+	float g = tables.decode[col.green];
+	float b = tables.decode[col.blue];
+	float l = cube_root(0.4122214708f * r + 0.5363325363f * g + 0.0514459929f * b);
+	float m = cube_root(0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b);
+	float s = cube_root(0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b);
+	return {
+		0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s,
+		1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s,
+		0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s
+	};
+}
+
+rgba_color rgb_of(const gamma_tables& tables, const oklab_color& col) {
+	float l = col.l + 0.3963377774f * col.a + 0.2158037573f * col.b;
+	float m = col.l - 0.1055613458f * col.a - 0.0638541728f * col.b;
+	float s = col.l - 0.0894841775f * col.a - 1.2914855480f * col.b;
+	l = l * l * l;
+	m = m * m * m;
+	s = s * s * s;
+	return rgba_color(
+		encode(tables, 4.0767416621f * l - 3.3077115913f * m + 0.2309699292f * s),
+		encode(tables, -1.2684380046f * l + 2.6097574011f * m - 0.3413193965f * s),
+		encode(tables, -0.0041960863f * l - 0.7034186147f * m + 1.7076147010f * s));
+}
+
+#if defined(__SSE2__)
+__m128 cube_root(__m128 x) {
+	// the integer-division by three is done in floats, it is only the estimate:
+	__m128i bits = _mm_castps_si128(x);
+	bits = _mm_add_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(bits), _mm_set1_ps(1.0f / 3))),
+		_mm_set1_epi32(0x2a514067));
+	__m128 y = _mm_castsi128_ps(bits);
+	const __m128 two = _mm_set1_ps(2);
+	const __m128 third = _mm_set1_ps(1.0f / 3);
+	y = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(two, y), _mm_div_ps(x, _mm_mul_ps(y, y))), third);
+	y = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(two, y), _mm_div_ps(x, _mm_mul_ps(y, y))), third);
+	return _mm_and_ps(y, _mm_cmpgt_ps(x, _mm_setzero_ps()));
+}
+
+// a*x + b*y + c*z with scalar factors:
+__m128 combine(float a, __m128 x, float b, __m128 y, float c, __m128 z) {
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a), x), _mm_mul_ps(_mm_set1_ps(b), y)),
+		_mm_mul_ps(_mm_set1_ps(c), z));
+}
+
+__m128 cube(__m128 x) {
+	return _mm_mul_ps(_mm_mul_ps(x, x), x);
+}
+
+/*
+ * the indices into the encode-table of four linear values
+ */
+void encode_indices(__m128 linear, int32_t* indices) {
+	linear = _mm_min_ps(_mm_set1_ps(1), _mm_max_ps(_mm_setzero_ps(), linear));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(indices), _mm_cvttps_epi32(
+		_mm_add_ps(_mm_mul_ps(linear, _mm_set1_ps(ENCODE_SCALE)), _mm_set1_ps(0.5f))));
+}
+#endif
+
+/*
+ * the interpolation of the components of two colors
+ */
+template<typename Color>
+Color mix(const Color& from, const Color& to, float t) {
+	return {from.l + (to.l - from.l) * t, from.a + (to.a - from.a) * t,
+		from.b + (to.b - from.b) * t};
+}
+
+float mix_hue(float from, float to, float t) {
+	float delta = to - from;
+	if (delta > 180) {
+		delta -= 360;
+	}
+	else if (delta < -180) {
+		delta += 360;
+	}
+	return wrap_hue(from + delta * t);
+}
+
+template<>
+hsv_color mix(const hsv_color& from, const hsv_color& to, float t) {
+	// grays have no hue of their own:
+	float from_hue = from.saturation > 0 ? from.hue : to.hue;
+	float to_hue = to.saturation > 0 ? to.hue : from.hue;
+	return {mix_hue(from_hue, to_hue, t), from.saturation + (to.saturation - from.saturation) * t,
+		from.value + (to.value - from.value) * t};
+}
+
+template<>
+hsl_color mix(const hsl_color& from, const hsl_color& to, float t) {
+	float from_hue = from.saturation > 0 ? from.hue : to.hue;
+	float to_hue = to.saturation > 0 ? to.hue : from.hue;
+	return {mix_hue(from_hue, to_hue, t), from.saturation + (to.saturation - from.saturation) * t,
+		from.lightness + (to.lightness - from.lightness) * t};
+}
+
+/*
+ * the conversions of a color-space for interpolate()
+ */
+template<typename Color>
+struct conversions;
+
+template<>
+struct conversions<hsv_color> {
+	static void to(const rgba_color* in, hsv_color* out, std::size_t count) {
+		vlpp::to_hsv(in, out, count);
+	}
+	static void from(const hsv_color* in, rgba_color* out, std::size_t count) {
+		vlpp::from_hsv(in, out, count);
+	}
+};
+
+template<>
+struct conversions<hsl_color> {
+	static void to(const rgba_color* in, hsl_color* out, std::size_t count) {
+		vlpp::to_hsl(in, out, count);
+	}
+	static void from(const hsl_color* in, rgba_color* out, std::size_t count) {
+		vlpp::from_hsl(in, out, count);
+	}
+};
+
+template<>
+struct conversions<lab_color> {
+	static void to(const rgba_color* in, lab_color* out, std::size_t count) {
+		vlpp::to_lab(in, out, count);
+	}
+	static void from(const lab_color* in, rgba_color* out, std::size_t count) {
+		vlpp::from_lab(in, out, count);
+	}
+};
+
+template<>
+struct conversions<oklab_color> {
+	static void to(const rgba_color* in, oklab_color* out, std::size_t count) {
+		vlpp::to_oklab(in, out, count);
+	}
+	static void from(const oklab_color* in, rgba_color* out, std::size_t count) {
+		vlpp::from_oklab(in, out, count);
+	}
+};
+
+/*
+ * Interpolates in blocks that fit on the stack; everything of a block is read before
+ * the result is written, so the result may be one of the inputs.
+ */
+template<typename Color>
+void interpolate_blocks(const rgba_color* from, const rgba_color* to, rgba_color* result,
+		std::size_t count, float t) {
+	const std::size_t BLOCK = 64;
+	Color from_block[BLOCK];
+	Color to_block[BLOCK];
+	uint8_t alpha[BLOCK];
+	for (std::size_t first = 0; first < count; first += BLOCK) {
+		std::size_t n = std::min(BLOCK, count - first);
+		conversions<Color>::to(from + first, from_block, n);
+		conversions<Color>::to(to + first, to_block, n);
+		for (std::size_t i = 0; i < n; ++i) {
+			from_block[i] = mix(from_block[i], to_block[i], t);
+			alpha[i] = static_cast<uint8_t>(std::lround(from[first + i].alpha
+				+ (to[first + i].alpha - from[first + i].alpha) * t));
+		}
+		conversions<Color>::from(from_block, result + first, n);
+		for (std::size_t i = 0; i < n; ++i) {
+			result[first + i].alpha = alpha[i];
+		}
+	}
+}
+
+} // anonymous namespace
+
+vlpp::color_space vlpp::color_space_from_string(const std::string& name) {
+	for (std::size_t i = 0; i < sizeof(NAMES) / sizeof(NAMES[0]); ++i) {
+		if (name == NAMES[i]) {
+			return static_cast<color_space>(i);
+		}
+	}
+	throw std::invalid_argument("unknown color-space: “" + name + "”");
+}
+
+const char* vlpp::to_string(color_space space) {
+	return NAMES[static_cast<std::size_t>(space)];
+}
+
+vlpp::hsv_color vlpp::to_hsv(const rgba_color& col) {
+	float r = col.red / 255.0f;
+	float g = col.green / 255.0f;
+	float b = col.blue / 255.0f;
+	float max = std::max(r, std::max(g, b));
+	float delta = max - std::min(r, std::min(g, b));
+	return {hue_of(r, g, b, max, delta), max > 0 ? delta / max : 0, max};
+}
+
+void vlpp::to_hsv(const rgba_color* in, hsv_color* out, std::size_t count) {
+	std::transform(in, in + count, out, [](const rgba_color& col) {
+		return to_hsv(col);
+	});
+}
+
+vlpp::rgba_color vlpp::from_hsv(const hsv_color& col) {
+	float chroma = col.value * col.saturation;
+	return from_hue(col.hue, chroma, col.value - chroma);
+}
+
+void vlpp::from_hsv(const hsv_color* in, rgba_color* out, std::size_t count) {
+	std::transform(in, in + count, out, [](const hsv_color& col) {
+		return from_hsv(col);
+	});
+}
+
+vlpp::hsl_color vlpp::to_hsl(const rgba_color& col) {
+	float r = col.red / 255.0f;
+	float g = col.green / 255.0f;
+	float b = col.blue / 255.0f;
+	float max = std::max(r, std::max(g, b));
+	float min = std::min(r, std::min(g, b));
+	float delta = max - min;
+	float lightness = (max + min) / 2;
+	float saturation = delta > 0 ? delta / (1 - std::fabs(2 * lightness - 1)) : 0;
+	return {hue_of(r, g, b, max, delta), std::min(1.0f, saturation), lightness};
+}
+
+void vlpp::to_hsl(const rgba_color* in, hsl_color* out, std::size_t count) {
+	std::transform(in, in + count, out, [](const rgba_color& col) {
+		return to_hsl(col);
+	});
+}
+
+vlpp::rgba_color vlpp::from_hsl(const hsl_color& col) {
+	float chroma = (1 - std::fabs(2 * col.lightness - 1)) * col.saturation;
+	return from_hue(col.hue, chroma, col.lightness - chroma / 2);
+}
+
+void vlpp::from_hsl(const hsl_color* in, rgba_color* out, std::size_t count) {
+	std::transform(in, in + count, out, [](const hsl_color& col) {
+		return from_hsl(col);
+	});
+}
+
+vlpp::lab_color vlpp::to_lab(const rgba_color& col) {
+	auto& tables = gamma();
+	float r = tables.decode[col.red];
+	float g = tables.decode[col.green];
+	float b = tables.decode[col.blue];
+	float x = lab_f((0.4124564f * r + 0.3575761f * g + 0.1804375f * b) / WHITE_X);
+	float y = lab_f(0.2126729f * r + 0.7151522f * g + 0.0721750f * b);
+	float z = lab_f((0.0193339f * r + 0.1191920f * g + 0.9503041f * b) / WHITE_Z);
+	return {116 * y - 16, 500 * (x - y), 200 * (y - z)};
+}
+
+void vlpp::to_lab(const rgba_color* in, lab_color* out, std::size_t count) {
+	std::transform(in, in + count, out, [](const rgba_color& col) {
+		return to_lab(col);
+	});
+}
+
+vlpp::rgba_color vlpp::from_lab(const lab_color& col) {
+	auto& tables = gamma();
+	float fy = (col.l + 16) / 116;
+	float x = lab_f_inverse(fy + col.a / 500) * WHITE_X;
+	float y = lab_f_inverse(fy);
+	float z = lab_f_inverse(fy - col.b / 200) * WHITE_Z;
+	return rgba_color(
+		encode(tables, 3.2404542f * x - 1.5371385f * y - 0.4985314f * z),
+		encode(tables, -0.9692660f * x + 1.8760108f * y + 0.0415560f * z),
+		encode(tables, 0.0556434f * x - 0.2040259f * y + 1.0572252f * z));
+}
+
+void vlpp::from_lab(const lab_color* in, rgba_color* out, std::size_t count) {
+	std::transform(in, in + count, out, [](const lab_color& col) {
+		return from_lab(col);
+	});
+}
+
+void vlpp::to_oklab(const rgba_color* in, oklab_color* out, std::size_t count) {
+	auto& tables = gamma();
+	std::size_t i = 0;
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4) {
+		auto& d = tables.decode;
+		const rgba_color* c = in + i;
+		__m128 r = _mm_setr_ps(d[c[0].red], d[c[1].red], d[c[2].red], d[c[3].red]);
+		__m128 g = _mm_setr_ps(d[c[0].green], d[c[1].green], d[c[2].green], d[c[3].green]);
+		__m128 b = _mm_setr_ps(d[c[0].blue], d[c[1].blue], d[c[2].blue], d[c[3].blue]);
+		__m128 l = cube_root(combine(0.4122214708f, r, 0.5363325363f, g, 0.0514459929f, b));
+		__m128 m = cube_root(combine(0.2119034982f, r, 0.6806995451f, g, 0.1073969566f, b));
+		__m128 s = cube_root(combine(0.0883024619f, r, 0.2817188376f, g, 0.6299787005f, b));
+		float lightness[4], a[4], bb[4];
+		_mm_storeu_ps(lightness, combine(0.2104542553f, l, 0.7936177850f, m, -0.0040720468f, s));
+		_mm_storeu_ps(a, combine(1.9779984951f, l, -2.4285922050f, m, 0.4505937099f, s));
+		_mm_storeu_ps(bb, combine(0.0259040371f, l, 0.7827717662f, m, -0.8086757660f, s));
+		for (std::size_t k = 0; k < 4; ++k) {
+			out[i + k] = {lightness[k], a[k], bb[k]};
+		}
+	}
+#endif
+	for (; i < count; ++i) {
+		out[i] = oklab_of(tables, in[i]);
+	}
+}
+
+vlpp::oklab_color vlpp::to_oklab(const rgba_color& col) {
+	return oklab_of(gamma(), col);
+}
+
+void vlpp::from_oklab(const oklab_color* in, rgba_color* out, std::size_t count) {
+	auto& tables = gamma();
+	std::size_t i = 0;
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4) {
+		const oklab_color* c = in + i;
+		__m128 lightness = _mm_setr_ps(c[0].l, c[1].l, c[2].l, c[3].l);
+		__m128 a = _mm_setr_ps(c[0].a, c[1].a, c[2].a, c[3].a);
+		__m128 b = _mm_setr_ps(c[0].b, c[1].b, c[2].b, c[3].b);
+		__m128 l = cube(combine(1, lightness, 0.3963377774f, a, 0.2158037573f, b));
+		__m128 m = cube(combine(1, lightness, -0.1055613458f, a, -0.0638541728f, b));
+		__m128 s = cube(combine(1, lightness, -0.0894841775f, a, -1.2914855480f, b));
+		int32_t r_index[4], g_index[4], b_index[4];
+		encode_indices(combine(4.0767416621f, l, -3.3077115913f, m, 0.2309699292f, s), r_index);
+		encode_indices(combine(-1.2684380046f, l, 2.6097574011f, m, -0.3413193965f, s), g_index);
+		encode_indices(combine(-0.0041960863f, l, -0.7034186147f, m, 1.7076147010f, s), b_index);
+		for (std::size_t k = 0; k < 4; ++k) {
+			out[i + k].red = tables.encode[static_cast<std::size_t>(r_index[k])];
+			out[i + k].green = tables.encode[static_cast<std::size_t>(g_index[k])];
+			out[i + k].blue = tables.encode[static_cast<std::size_t>(b_index[k])];
+			out[i + k].alpha = UINT8_MAX;
+		}
+	}
+#endif
+	for (; i < count; ++i) {
+		out[i] = rgb_of(tables, in[i]);
+	}
+}
+
+vlpp::rgba_color vlpp::from_oklab(const oklab_color& col) {
+	return rgb_of(gamma(), col);
+}
+
+vlpp::rgba_color vlpp::interpolate(color_space space, const rgba_color& from, const rgba_color& to,
+		float t) {
+	rgba_color result;
+	interpolate(space, &from, &to, &result, 1, t);
+	return result;
+}
+
+void vlpp::interpolate(color_space space, const rgba_color* from, const rgba_color* to,
+		rgba_color* result, std::size_t count, float t) {
+	t = std::min(1.0f, std::max(0.0f, t));
+	switch (space) {
+		case color_space::hsv:
+			interpolate_blocks<hsv_color>(from, to, result, count, t);
+			break;
+		case color_space::hsl:
+			interpolate_blocks<hsl_color>(from, to, result, count, t);
+			break;
+		case color_space::lab:
+			interpolate_blocks<lab_color>(from, to, result, count, t);
+			break;
+		case color_space::oklab:
+			interpolate_blocks<oklab_color>(from, to, result, count, t);
+			break;
+		default:
+			blend(from, to, result, count, blend_weight(t));
+	}
+}
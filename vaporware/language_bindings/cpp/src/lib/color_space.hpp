@@ -0,0 +1,195 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COLOR_SPACE_HPP
+#define COLOR_SPACE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "rgba_color.hpp"
+
+namespace vlpp {
+
+/**
+ * @brief A color in HSV.
+ */
+struct hsv_color {
+	/**
+	 * @brief the hue in degrees, in [0, 360)
+	 */
+	float hue;
+	
+	/**
+	 * @brief the saturation in [0, 1]
+	 */
+	float saturation;
+	
+	/**
+	 * @brief the value in [0, 1]
+	 */
+	float value;
+};
+
+/**
+ * @brief A color in HSL.
+ */
+struct hsl_color {
+	/**
+	 * @brief the hue in degrees, in [0, 360)
+	 */
+	float hue;
+	
+	/**
+	 * @brief the saturation in [0, 1]
+	 */
+	float saturation;
+	
+	/**
+	 * @brief the lightness in [0, 1]
+	 */
+	float lightness;
+};
+
+/**
+ * @brief A color in CIELab with the white-point D65.
+ */
+struct lab_color {
+	/**
+	 * @brief the lightness in [0, 100]
+	 */
+	float l;
+	
+	/**
+	 * @brief the green-red-axis
+	 */
+	float a;
+	
+	/**
+	 * @brief the blue-yellow-axis
+	 */
+	float b;
+};
+
+/**
+ * @brief A color in OKLab.
+ */
+struct oklab_color {
+	/**
+	 * @brief the lightness in [0, 1]
+	 */
+	float l;
+	
+	/**
+	 * @brief the green-red-axis
+	 */
+	float a;
+	
+	/**
+	 * @brief the blue-yellow-axis
+	 */
+	float b;
+};
+
+/**
+ * @brief the color-spaces that colors can be interpolated in
+ */
+enum class color_space {
+	rgb,
+	hsv,
+	hsl,
+	lab,
+	oklab
+};
+
+/**
+ * @brief Parses the name of a color-space, e.g. “oklab”.
+ * @throws std::invalid_argument if there is no such color-space
+ */
+color_space color_space_from_string(const std::string& name);
+
+/**
+ * @brief the name of a color-space
+ */
+const char* to_string(color_space space);
+
+// The conversions treat the red, green and blue values of an rgba_color as sRGB, like
+// the colors of palettes and color-pickers; Lab and OKLab are computed from linear
+// light. The alpha-value is not converted, the colors from the other spaces are opaque.
+// The array-versions convert count colors from in to out.
+
+hsv_color to_hsv(const rgba_color& col);
+void to_hsv(const rgba_color* in, hsv_color* out, std::size_t count);
+rgba_color from_hsv(const hsv_color& col);
+void from_hsv(const hsv_color* in, rgba_color* out, std::size_t count);
+
+hsl_color to_hsl(const rgba_color& col);
+void to_hsl(const rgba_color* in, hsl_color* out, std::size_t count);
+rgba_color from_hsl(const hsl_color& col);
+void from_hsl(const hsl_color* in, rgba_color* out, std::size_t count);
+
+lab_color to_lab(const rgba_color& col);
+void to_lab(const rgba_color* in, lab_color* out, std::size_t count);
+rgba_color from_lab(const lab_color& col);
+void from_lab(const lab_color* in, rgba_color* out, std::size_t count);
+
+/**
+ * @brief Converts colors to OKLab; on x86 four colors at a time with SSE2.
+ */
+void to_oklab(const rgba_color* in, oklab_color* out, std::size_t count);
+oklab_color to_oklab(const rgba_color& col);
+
+/**
+ * @brief Converts colors from OKLab; on x86 four colors at a time with SSE2.
+ */
+void from_oklab(const oklab_color* in, rgba_color* out, std::size_t count);
+rgba_color from_oklab(const oklab_color& col);
+
+/**
+ * @brief Interpolates between two colors in a color-space.
+ *
+ * Hues take the shorter way around the circle; the hue of a gray is taken from the
+ * other color. The alpha-value is interpolated linearly.
+ *
+ * @param space the color-space
+ * @param from the color at 0
+ * @param to the color at 1
+ * @param t the position, clamped to [0, 1]
+ * @return the interpolated color
+ */
+rgba_color interpolate(color_space space, const rgba_color& from, const rgba_color& to, float t);
+
+/**
+ * @brief Interpolates between two arrays of colors in a color-space.
+ *
+ * This converts the colors in blocks on the stack, so it doesn't allocate; in rgb it
+ * uses blend().
+ *
+ * @param space the color-space
+ * @param from the colors at 0
+ * @param to the colors at 1
+ * @param result the interpolated colors; this may be from or to
+ * @param count the number of colors in each array
+ * @param t the position, clamped to [0, 1]
+ */
+void interpolate(color_space space, const rgba_color* from, const rgba_color* to,
+		rgba_color* result, std::size_t count, float t);
+
+} // namespace vlpp
+
+#endif // COLOR_SPACE_HPP
@@ -0,0 +1,208 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "concurrent_client.hpp"
+#include "frame_scheduler.hpp"
+#include "protocol.hpp"
+
+#include <atomic>
+#include <thread>
+
+// the slots must never fall back to locks:
+#if ATOMIC_INT_LOCK_FREE != 2 || ATOMIC_LLONG_LOCK_FREE != 2
+	#error "Your platform doesn't support lockfree atomic integers."
+#endif
+
+enum : std::size_t { MASK_BITS = 64, MASK_SIZE = vlpp::LED_COUNT / MASK_BITS };
+
+//pimpl-class (private members of concurrent_client):
+class vlpp::concurrent_client::concurrent_client_impl {
+	public:
+		concurrent_client_impl(const std::string& server, const std::string& token, uint16_t port,
+			std::chrono::microseconds tick);
+		~concurrent_client_impl();
+		void set_led(uint16_t led, const rgba_color& col) {
+			_colors[led].store(pack(col), std::memory_order_relaxed);
+			// the release pairs with the acquire of the sender, so it will see the color:
+			_changed[led / MASK_BITS].fetch_or(uint64_t(1) << (led % MASK_BITS),
+				std::memory_order_release);
+		}
+		void check_sender();
+		void set_resilient(bool resilient) {
+			_resilient.store(resilient, std::memory_order_relaxed);
+		}
+		
+	private:
+		static uint32_t pack(const rgba_color& col) {
+			return uint32_t(col.red) << 24 | uint32_t(col.green) << 16
+				| uint32_t(col.blue) << 8 | col.alpha;
+		}
+		static rgba_color unpack(uint32_t col) {
+			return {uint8_t(col >> 24), uint8_t(col >> 16), uint8_t(col >> 8), uint8_t(col)};
+		}
+		void run();
+		void send_changes();
+		
+		vlpp::client _client;
+		vlpp::frame_scheduler _scheduler;
+		std::unique_ptr<std::atomic<uint32_t>[]> _colors;
+		std::unique_ptr<std::atomic<uint64_t>[]> _changed;
+		std::atomic<bool> _stop;
+		// requested by the users and applied by the sender:
+		std::atomic<bool> _resilient;
+		bool _client_resilient = false;
+		// _error is written before _failed is set and never changes afterwards:
+		std::atomic<bool> _failed;
+		std::exception_ptr _error;
+		// the frame that is currently sent (used by the sender only):
+		std::vector<rgba_color> _frame;
+		std::thread _sender;
+};
+
+///////////
+
+vlpp::concurrent_client::concurrent_client(const std::string& server, const std::string& token,
+		uint16_t port, std::chrono::microseconds tick):
+	_impl(std::make_shared<concurrent_client_impl>(server, token, port, tick)) {
+}
+
+void vlpp::concurrent_client::set_led(uint16_t led_id, const rgba_color& col) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::concurrent_client");
+	}
+	_impl->check_sender();
+	_impl->set_led(led_id, col);
+}
+
+void vlpp::concurrent_client::set_leds(const std::vector<uint16_t>& led_ids, const rgba_color& col) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::concurrent_client");
+	}
+	_impl->check_sender();
+	for (auto led: led_ids) {
+		_impl->set_led(led, col);
+	}
+}
+
+void vlpp::concurrent_client::set_leds(uint16_t first, const rgba_color* colors, std::size_t count) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::concurrent_client");
+	}
+	if (count > vlpp::LED_COUNT - first) {
+		throw std::invalid_argument("invalid range");
+	}
+	_impl->check_sender();
+	for (std::size_t i = 0; i < count; ++i) {
+		_impl->set_led(static_cast<uint16_t>(first + i), colors[i]);
+	}
+}
+
+void vlpp::concurrent_client::set_resilient(bool resilient) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::concurrent_client");
+	}
+	_impl->set_resilient(resilient);
+}
+
+///////// now: the private stuff
+
+vlpp::concurrent_client::concurrent_client_impl::concurrent_client_impl(const std::string& server,
+		const std::string& token, uint16_t port, std::chrono::microseconds tick):
+	_client(server, token, port),
+	_scheduler(1e6 / static_cast<double>(tick.count())),
+	_colors(new std::atomic<uint32_t>[vlpp::LED_COUNT]),
+	_changed(new std::atomic<uint64_t>[MASK_SIZE]),
+	_stop(false),
+	_resilient(false),
+	_failed(false),
+	_frame(vlpp::LED_COUNT) {
+	for (std::size_t i = 0; i < vlpp::LED_COUNT; ++i) {
+		_colors[i].store(0, std::memory_order_relaxed);
+	}
+	for (std::size_t i = 0; i < MASK_SIZE; ++i) {
+		_changed[i].store(0, std::memory_order_relaxed);
+	}
+	_sender = std::thread([this] {
+		run();
+	});
+}
+
+vlpp::concurrent_client::concurrent_client_impl::~concurrent_client_impl() {
+	_stop = true;
+	_scheduler.stop();
+	_sender.join();
+}
+
+void vlpp::concurrent_client::concurrent_client_impl::check_sender() {
+	if (_failed.load(std::memory_order_acquire)) {
+		std::rethrow_exception(_error);
+	}
+}
+
+void vlpp::concurrent_client::concurrent_client_impl::run() {
+	try {
+		_scheduler.run([this](const vlpp::frame_scheduler::frame_info&) {
+			send_changes();
+			return !_stop;
+		});
+		// don't lose the last changes:
+		send_changes();
+	}
+	catch (std::exception&) {
+		_error = std::current_exception();
+		_failed.store(true, std::memory_order_release);
+	}
+}
+
+void vlpp::concurrent_client::concurrent_client_impl::send_changes() {
+	bool resilient = _resilient.load(std::memory_order_relaxed);
+	if (resilient != _client_resilient) {
+		_client.set_resilient(resilient);
+		_client_resilient = resilient;
+	}
+	// changed LEDs with consecutive IDs are sent as one span:
+	std::size_t span_first = 0;
+	std::size_t span_count = 0;
+	bool changed = false;
+	for (std::size_t i = 0; i < MASK_SIZE; ++i) {
+		if (!_changed[i].load(std::memory_order_relaxed)) {
+			continue;
+		}
+		uint64_t bits = _changed[i].exchange(0, std::memory_order_acquire);
+		while (bits) {
+			std::size_t led = i * MASK_BITS + static_cast<std::size_t>(__builtin_ctzll(bits));
+			bits &= bits - 1;
+			_frame[led] = unpack(_colors[led].load(std::memory_order_relaxed));
+			if (span_count && led == span_first + span_count) {
+				++span_count;
+				continue;
+			}
+			if (span_count) {
+				_client.set_leds(static_cast<uint16_t>(span_first), &_frame[span_first], span_count);
+			}
+			span_first = led;
+			span_count = 1;
+			changed = true;
+		}
+	}
+	if (!changed) {
+		return;
+	}
+	_client.set_leds(static_cast<uint16_t>(span_first), &_frame[span_first], span_count);
+	_client.flush();
+}
@@ -0,0 +1,119 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONCURRENT_CLIENT_HPP
+#define CONCURRENT_CLIENT_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "client.hpp"
+#include "rgba_color.hpp"
+
+namespace vlpp {
+
+/**
+ * @brief A client that may be used by any number of threads at the same time.
+ *
+ * Setting an LED only stores the color in a table of atomic slots and marks the
+ * LED as changed; this never blocks and never allocates. A sender-thread collects
+ * the changed LEDs once per tick and sends them with a single strobe, so the
+ * updates of all threads are coalesced into one frame. If an LED is set more than
+ * once per tick, only the last color is sent.
+ */
+class concurrent_client {
+public:
+	/**
+	 * @brief the default constructor.
+	 *
+	 * Note that this is not properly constructed afterwards, so any
+	 * attempt of using it will result in a vlpp::uninitialized_error
+	 * beeing thrown.
+	 */
+	concurrent_client() = default;
+	
+	/**
+	 * @brief Connects to the server and starts the sender-thread.
+	 * @param server the servername
+	 * @param token the authentication-token
+	 * @param port the server-port
+	 * @param tick the time between two frames
+	 * @throws std::invalid_argument if the token has an invalid size
+	 * @throws vlpp::connection_failure if no connection could be created
+	 */
+	concurrent_client(const std::string& server, const std::string& token,
+		uint16_t port = client::DEFAULT_PORT,
+		std::chrono::microseconds tick = std::chrono::microseconds(10000));
+	
+	concurrent_client(const concurrent_client&) = delete;
+	concurrent_client(concurrent_client&&) = default;
+	
+	concurrent_client &operator=(const concurrent_client&) = delete;
+	concurrent_client &operator=(concurrent_client&&) = default;
+	
+	/**
+	 * @brief Sets an LED with the next frame; this is threadsafe and lock-free.
+	 * @param led_id the ID of the LED
+	 * @param col the new color
+	 * @throws vlpp::connection_failure if the sender-thread failed
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_led(uint16_t led_id, const rgba_color& col);
+	
+	/**
+	 * @brief Sets some LEDs with the next frame; this is threadsafe and lock-free.
+	 *
+	 * The LEDs are not set atomically, so other threads might set some of them in between.
+	 * @param led_ids the IDs of the LEDs
+	 * @param col the new color
+	 * @throws vlpp::connection_failure if the sender-thread failed
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_leds(const std::vector<uint16_t>& led_ids, const rgba_color& col);
+	
+	/**
+	 * @brief Sets consecutive LEDs with the next frame; this is threadsafe and lock-free.
+	 * @param first the ID of the LED that gets the first color
+	 * @param colors the colors
+	 * @param count the number of colors
+	 * @throws std::invalid_argument if the IDs would exceed the largest LED-ID
+	 * @throws vlpp::connection_failure if the sender-thread failed
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_leds(uint16_t first, const rgba_color* colors, std::size_t count);
+	
+	/**
+	 * @brief Enables or disables the resilient mode of the underlying vlpp::client.
+	 *
+	 * The sender-thread applies this before the next frame; see vlpp::client::set_resilient().
+	 * @param resilient true to reconnect in the background instead of failing
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_resilient(bool resilient);
+	
+private:
+	class concurrent_client_impl;
+	// see vlpp::client for the reason of the shared_ptr:
+	std::shared_ptr<concurrent_client_impl> _impl;
+};
+
+} // namespace vlpp
+
+#endif // CONCURRENT_CLIENT_HPP
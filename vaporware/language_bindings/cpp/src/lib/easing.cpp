@@ -0,0 +1,41 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "easing.hpp"
+
+#include <stdexcept>
+
+constexpr double vlpp::easing::perceptual::GAMMA;
+
+namespace {
+
+const char* const NAMES[] = {"linear", "cubic", "sine", "exponential", "perceptual"};
+
+} // anonymous namespace
+
+vlpp::easing::curve vlpp::easing::curve_from_string(const std::string& name) {
+	for (std::size_t i = 0; i < sizeof(NAMES) / sizeof(NAMES[0]); ++i) {
+		if (name == NAMES[i]) {
+			return static_cast<curve>(i);
+		}
+	}
+	throw std::invalid_argument("unknown easing-curve: “" + name + "”");
+}
+
+const char* vlpp::easing::to_string(curve c) {
+	return NAMES[static_cast<std::size_t>(c)];
+}
@@ -0,0 +1,200 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EASING_HPP
+#define EASING_HPP
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "blend.hpp"
+
+namespace vlpp {
+
+/**
+ * @brief Easing-curves for fades.
+ *
+ * A curve is a policy with a static function ease() that maps the progress of a fade in
+ * [0, 1] to the share of the new color in [0, 1]. Since the curve is a template-argument,
+ * it is inlined into the loop of the fade; table() additionally provides it as 256
+ * precomputed blend-weights.
+ */
+namespace easing {
+
+/**
+ * @brief a constant speed
+ */
+struct linear {
+	static double ease(double t) noexcept {
+		return t;
+	}
+};
+
+/**
+ * @brief slow at both ends and fast in the middle, with a cubic in each half
+ */
+struct cubic {
+	static double ease(double t) noexcept {
+		if (t < 0.5) {
+			return 4 * t * t * t;
+		}
+		double rest = 2 - 2 * t;
+		return 1 - rest * rest * rest / 2;
+	}
+};
+
+/**
+ * @brief half a period of a cosine; softer than cubic at both ends
+ */
+struct sine {
+	static double ease(double t) noexcept {
+		return (1 - std::cos(3.14159265358979323846 * t)) / 2;
+	}
+};
+
+/**
+ * @brief almost nothing happens at both ends, the change is concentrated in the middle
+ */
+struct exponential {
+	static double ease(double t) noexcept {
+		if (t <= 0 || t >= 1) {
+			return t <= 0 ? 0 : 1;
+		}
+		return t < 0.5 ? std::exp2(20 * t - 10) / 2 : 1 - std::exp2(10 - 20 * t) / 2;
+	}
+};
+
+/**
+ * @brief constant speed of the perceived brightness
+ *
+ * The LEDs are driven by PWM, so their output is linear in the color-values, but the
+ * eye's response to it is roughly a power of 1/GAMMA. The share follows t^GAMMA, so a
+ * fade from dark to bright appears to brighten evenly instead of jumping up at first.
+ */
+struct perceptual {
+	static constexpr double GAMMA = 2.2;
+	
+	static double ease(double t) noexcept {
+		return std::pow(t, GAMMA);
+	}
+};
+
+/**
+ * @brief the curves that can be selected at runtime
+ */
+enum class curve {
+	linear,
+	cubic,
+	sine,
+	exponential,
+	perceptual
+};
+
+/**
+ * @brief Parses the name of a curve, e.g. “sine”.
+ * @throws std::invalid_argument if there is no such curve
+ */
+curve curve_from_string(const std::string& name);
+
+/**
+ * @brief the name of a curve
+ */
+const char* to_string(curve c);
+
+/**
+ * @brief Calls visitor(Curve()) with the policy of a curve.
+ *
+ * This selects the policy once, so that everything the visitor does with it is
+ * compiled for that curve.
+ *
+ * @param c the curve
+ * @param visitor a function-object with a templated operator() that takes the policy
+ */
+template<typename Visitor>
+void visit(curve c, Visitor&& visitor) {
+	switch (c) {
+		case curve::cubic:
+			visitor(cubic());
+			break;
+		case curve::sine:
+			visitor(sine());
+			break;
+		case curve::exponential:
+			visitor(exponential());
+			break;
+		case curve::perceptual:
+			visitor(perceptual());
+			break;
+		default:
+			visitor(linear());
+	}
+}
+
+/**
+ * @brief the blend-weight of the new color for a step of a fade
+ * @param step the current step, from 0 to steps
+ * @param steps the number of steps of the fade
+ */
+template<typename Curve>
+uint16_t weight(int step, int steps) {
+	return blend_weight(Curve::ease(static_cast<double>(step) / steps));
+}
+
+/**
+ * @brief the number of entries of a table
+ */
+const std::size_t TABLE_SIZE = 256;
+
+/**
+ * @brief the blend-weights of a curve for the progress i/(TABLE_SIZE-1)
+ *
+ * The table is computed on the first use.
+ */
+template<typename Curve>
+const std::array<uint16_t, TABLE_SIZE>& table() {
+	static const std::array<uint16_t, TABLE_SIZE> weights = [] {
+		std::array<uint16_t, TABLE_SIZE> result;
+		for (std::size_t i = 0; i < TABLE_SIZE; ++i) {
+			result[i] = blend_weight(Curve::ease(static_cast<double>(i) / (TABLE_SIZE - 1)));
+		}
+		return result;
+	}();
+	return weights;
+}
+
+/**
+ * @brief the blend-weight for a step from the table of the curve
+ *
+ * With more than TABLE_SIZE-1 steps, neighbouring steps may get the same weight.
+ *
+ * @param step the current step, from 0 to steps
+ * @param steps the number of steps of the fade
+ */
+template<typename Curve>
+uint16_t lookup(int step, int steps) {
+	return table<Curve>()[static_cast<std::size_t>(step) * (TABLE_SIZE - 1)
+		/ static_cast<std::size_t>(steps)];
+}
+
+} // namespace easing
+
+} // namespace vlpp
+
+#endif // EASING_HPP
@@ -0,0 +1,135 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "frame_scheduler.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <stdexcept>
+
+#include <time.h>
+
+namespace {
+
+std::chrono::nanoseconds monotonic_now() {
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return std::chrono::seconds(now.tv_sec) + std::chrono::nanoseconds(now.tv_nsec);
+}
+
+/*
+ * Sleeps until an absolute point of CLOCK_MONOTONIC.
+ */
+void sleep_until(std::chrono::nanoseconds deadline) {
+	timespec ts;
+	ts.tv_sec = static_cast<time_t>(deadline.count() / 1000000000);
+	ts.tv_nsec = static_cast<long>(deadline.count() % 1000000000);
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+}
+
+} // anonymous namespace
+
+vlpp::frame_scheduler::frame_scheduler(double fps, late_policy policy):
+	_policy(policy), _stop(false) {
+	if (!(fps > 0) || !std::isfinite(fps)) {
+		throw std::invalid_argument("the framerate must be positive and finite");
+	}
+	// run() divides by the period, so it must not be rounded down to zero:
+	_period = std::max(std::chrono::nanoseconds(1),
+		std::chrono::nanoseconds(static_cast<std::chrono::nanoseconds::rep>(1e9 / fps)));
+}
+
+void vlpp::frame_scheduler::run(const std::function<bool(const frame_info&)>& render) {
+	_frames = 0;
+	_missed = 0;
+	_jitter_sum = 0;
+	_jitter_square_sum = 0;
+	_max_jitter = 0;
+	
+	const auto start = monotonic_now();
+	// the time all deadlines are relative to; coalescing moves it:
+	auto origin = start;
+	auto deadline_of = [this, &origin](std::size_t frame) {
+		return origin + _period * static_cast<std::chrono::nanoseconds::rep>(frame);
+	};
+	std::size_t frame = 0;
+	std::size_t missed = 0;
+	while (!_stop) {
+		auto deadline = deadline_of(frame);
+		auto now = monotonic_now();
+		if (now < deadline) {
+			sleep_until(deadline);
+			now = monotonic_now();
+		}
+		double jitter = std::chrono::duration<double, std::micro>(now - deadline).count();
+		_jitter_sum += jitter;
+		_jitter_square_sum += jitter * jitter;
+		_max_jitter = std::max(_max_jitter, jitter);
+		
+		bool go_on = render(frame_info{frame, deadline - start, missed});
+		++_frames;
+		_elapsed = monotonic_now() - start;
+		if (!go_on) {
+			break;
+		}
+		
+		++frame;
+		missed = 0;
+		now = monotonic_now();
+		if (now < deadline_of(frame)) {
+			continue;
+		}
+		// we are late, this is the last frame whose deadline has passed:
+		auto due = static_cast<std::size_t>((now - origin) / _period);
+		switch (_policy) {
+			case late_policy::skip:
+				missed = due - frame + 1;
+				frame = due + 1;
+				break;
+			case late_policy::coalesce:
+				// render it right now and continue from there:
+				missed = due - frame;
+				frame = due;
+				origin = now - _period * static_cast<std::chrono::nanoseconds::rep>(frame);
+				break;
+		}
+		_missed += missed;
+	}
+	_stop = false;
+}
+
+void vlpp::frame_scheduler::stop() {
+	_stop = true;
+}
+
+vlpp::frame_scheduler::statistics vlpp::frame_scheduler::stats() const {
+	statistics returnval;
+	returnval.frames = _frames;
+	returnval.missed = _missed;
+	if (_frames == 0) {
+		return returnval;
+	}
+	double seconds = std::chrono::duration<double>(_elapsed).count();
+	returnval.fps = seconds > 0 ? _frames / seconds : 0;
+	returnval.mean_jitter = _jitter_sum / _frames;
+	returnval.jitter_deviation = std::sqrt(std::max(0.0,
+		_jitter_square_sum / _frames - returnval.mean_jitter * returnval.mean_jitter));
+	returnval.max_jitter = _max_jitter;
+	return returnval;
+}
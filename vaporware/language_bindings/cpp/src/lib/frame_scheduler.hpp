@@ -0,0 +1,156 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAME_SCHEDULER_HPP
+#define FRAME_SCHEDULER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+
+namespace vlpp {
+
+/**
+ * @brief Runs a render-function at a fixed rate.
+ *
+ * The frames are scheduled at absolute deadlines of CLOCK_MONOTONIC, so the time
+ * that is spent rendering, serializing and sending a frame doesn't add up to a drift.
+ */
+class frame_scheduler {
+public:
+	/**
+	 * @brief What to do if rendering a frame took longer than its period.
+	 */
+	enum class late_policy {
+		/**
+		 * @brief Drop the missed frames and wait for the next deadline, so the
+		 *        frames stay in phase.
+		 */
+		skip,
+		
+		/**
+		 * @brief Render one frame immediately for all missed ones and schedule
+		 *        the following frames relative to it.
+		 */
+		coalesce
+	};
+	
+	/**
+	 * @brief Information about the frame that shall be rendered.
+	 */
+	struct frame_info {
+		/**
+		 * @brief the number of the frame, counted in periods since the start; it
+		 *        jumps if frames are missed
+		 */
+		std::size_t frame;
+		
+		/**
+		 * @brief the deadline of the frame relative to the start
+		 */
+		std::chrono::nanoseconds deadline;
+		
+		/**
+		 * @brief the number of frames that were missed right before this one
+		 */
+		std::size_t missed;
+	};
+	
+	/**
+	 * @brief Statistics about the frames that were rendered so far.
+	 */
+	struct statistics {
+		/**
+		 * @brief the number of frames that were rendered
+		 */
+		std::size_t frames = 0;
+		
+		/**
+		 * @brief the number of frames that were missed
+		 */
+		std::size_t missed = 0;
+		
+		/**
+		 * @brief the achieved frames per second
+		 */
+		double fps = 0;
+		
+		/**
+		 * @brief the mean delay between deadline and wakeup in µs
+		 */
+		double mean_jitter = 0;
+		
+		/**
+		 * @brief the standard deviation of the delay in µs
+		 */
+		double jitter_deviation = 0;
+		
+		/**
+		 * @brief the maximum delay in µs
+		 */
+		double max_jitter = 0;
+	};
+	
+	/**
+	 * @brief Creates a scheduler.
+	 * @param fps the target frames per second
+	 * @param policy what to do with late frames
+	 * @throws std::invalid_argument if fps is not positive or not finite
+	 */
+	explicit frame_scheduler(double fps, late_policy policy = late_policy::skip);
+	
+	frame_scheduler(const frame_scheduler&) = delete;
+	frame_scheduler &operator=(const frame_scheduler&) = delete;
+	
+	/**
+	 * @brief Calls the render-function once per period until it returns false
+	 *        or stop() is called.
+	 * @param render the render-function
+	 */
+	void run(const std::function<bool(const frame_info&)>& render);
+	
+	/**
+	 * @brief Lets the current or next call of run() return after the current frame;
+	 *        this may be called from any thread.
+	 */
+	void stop();
+	
+	/**
+	 * @brief Returns the statistics of the last or current call of run().
+	 *
+	 * This must not be called from another thread while run() is active.
+	 */
+	statistics stats() const;
+	
+private:
+	std::chrono::nanoseconds _period;
+	late_policy _policy;
+	std::atomic<bool> _stop;
+	
+	// the raw data of the statistics:
+	std::size_t _frames = 0;
+	std::size_t _missed = 0;
+	std::chrono::nanoseconds _elapsed{0};
+	double _jitter_sum = 0;
+	double _jitter_square_sum = 0;
+	double _max_jitter = 0;
+};
+
+} // namespace vlpp
+
+#endif // FRAME_SCHEDULER_HPP
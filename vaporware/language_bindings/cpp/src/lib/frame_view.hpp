@@ -0,0 +1,98 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAME_VIEW_HPP
+#define FRAME_VIEW_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "protocol.hpp"
+#include "rgba_color.hpp"
+
+namespace vlpp {
+
+/**
+ * @brief Describes a frame that consists of colors in memory owned by the caller.
+ *
+ * A frame_view only stores pointers, so building it is cheap and the colors are never
+ * copied; see vlpp::client::submit(). The colors must stay valid and unchanged until
+ * the frame has been submitted.
+ */
+class frame_view {
+public:
+	/**
+	 * @brief Consecutive LEDs and their colors.
+	 */
+	struct span {
+		uint16_t first;
+		const rgba_color* colors;
+		std::size_t count;
+	};
+	
+	/**
+	 * @brief Adds consecutive LEDs to the frame.
+	 * @param first the ID of the LED that gets the first color
+	 * @param colors the colors; the LED first+i gets colors[i]
+	 * @param count the number of colors
+	 * @return this frame_view
+	 * @throws std::invalid_argument if the IDs would exceed the largest LED-ID
+	 */
+	frame_view& add(uint16_t first, const rgba_color* colors, std::size_t count) {
+		if (count > LED_COUNT - first) {
+			throw std::invalid_argument("invalid range");
+		}
+		if (count) {
+			_spans.push_back(span{first, colors, count});
+		}
+		return *this;
+	}
+	
+	/**
+	 * @brief Adds consecutive LEDs to the frame.
+	 * @param first the ID of the LED that gets the first color
+	 * @param colors the colors; the vector must not be resized until the frame is submitted
+	 * @return this frame_view
+	 * @throws std::invalid_argument if the IDs would exceed the largest LED-ID
+	 */
+	frame_view& add(uint16_t first, const std::vector<rgba_color>& colors) {
+		return add(first, colors.data(), colors.size());
+	}
+	
+	/**
+	 * @brief Removes all spans, so the frame_view can be reused without allocations.
+	 */
+	void clear() {
+		_spans.clear();
+	}
+	
+	/**
+	 * @brief the spans in the order they were added
+	 */
+	const std::vector<span>& spans() const {
+		return _spans;
+	}
+	
+private:
+	std::vector<span> _spans;
+};
+
+} // namespace vlpp
+
+#endif // FRAME_VIEW_HPP
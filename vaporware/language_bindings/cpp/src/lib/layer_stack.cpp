@@ -0,0 +1,378 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "layer_stack.hpp"
+#include "protocol.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static_assert(vlpp::layer_stack::TILE_SIZE % 16 == 0, "the kernels blend 16 LEDs at a time");
+
+namespace {
+
+using vlpp::blend_mode;
+using vlpp::rgba_color;
+
+const std::size_t TILE_SIZE = vlpp::layer_stack::TILE_SIZE;
+
+/*
+ * x/255, rounded; x is at most 255*255
+ */
+unsigned divide(unsigned x) {
+	return (x + 127) / 255;
+}
+
+unsigned composite_channel(blend_mode mode, unsigned below, unsigned above, unsigned alpha) {
+	switch (mode) {
+		case blend_mode::add:
+			return std::min(255u, below + divide(above * alpha));
+		case blend_mode::multiply:
+			above = divide(above * below);
+			break;
+		case blend_mode::screen:
+			above = above + below - divide(above * below);
+			break;
+		default:
+			break;
+	}
+	return divide(above * alpha + below * (255 - alpha));
+}
+
+#if defined(__SSE2__)
+/*
+ * x/255, rounded, in 16-bit lanes: with t = x + 128, (t + t/256) / 256 is exact for
+ * x up to 255*255
+ */
+__m128i divide(__m128i x) {
+	x = _mm_add_epi16(x, _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+/*
+ * composite_channel() for eight LEDs in 16-bit lanes; the result of add may exceed
+ * 255 and is saturated when it is packed
+ */
+template<blend_mode Mode>
+__m128i composite_lanes(__m128i below, __m128i above, __m128i alpha) {
+	if (Mode == blend_mode::add) {
+		return _mm_add_epi16(below, divide(_mm_mullo_epi16(above, alpha)));
+	}
+	if (Mode == blend_mode::multiply) {
+		above = divide(_mm_mullo_epi16(above, below));
+	}
+	else if (Mode == blend_mode::screen) {
+		above = _mm_sub_epi16(_mm_add_epi16(above, below), divide(_mm_mullo_epi16(above, below)));
+	}
+	__m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+	return divide(_mm_add_epi16(_mm_mullo_epi16(above, alpha), _mm_mullo_epi16(below, inverse)));
+}
+
+template<blend_mode Mode>
+void composite_channel16(uint8_t* below, const uint8_t* above, __m128i alpha_lo, __m128i alpha_hi) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(below));
+	__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(above));
+	__m128i lo = composite_lanes<Mode>(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(a, zero), alpha_lo);
+	__m128i hi = composite_lanes<Mode>(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(a, zero), alpha_hi);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(below), _mm_packus_epi16(lo, hi));
+}
+#endif
+
+/*
+ * The channels of a layer or of the frame, TILE_SIZE-aligned in length.
+ */
+struct channels {
+	explicit channels(std::size_t size): red(size), green(size), blue(size) {}
+	
+	std::vector<uint8_t> red;
+	std::vector<uint8_t> green;
+	std::vector<uint8_t> blue;
+};
+
+struct layer: channels {
+	layer(std::size_t size, blend_mode mode):
+		channels(size), alpha(size), touched(size / TILE_SIZE), mode(mode) {}
+	
+	std::vector<uint8_t> alpha;
+	// whether a tile has been drawn on since the last clear:
+	std::vector<uint8_t> touched;
+	blend_mode mode;
+	std::mutex mutex;
+};
+
+template<blend_mode Mode>
+void composite_tile(channels& frame, const layer& above, std::size_t first) {
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	for (std::size_t i = first; i < first + TILE_SIZE; i += 16) {
+		__m128i alpha = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&above.alpha[i]));
+		__m128i alpha_lo = _mm_unpacklo_epi8(alpha, zero);
+		__m128i alpha_hi = _mm_unpackhi_epi8(alpha, zero);
+		composite_channel16<Mode>(&frame.red[i], &above.red[i], alpha_lo, alpha_hi);
+		composite_channel16<Mode>(&frame.green[i], &above.green[i], alpha_lo, alpha_hi);
+		composite_channel16<Mode>(&frame.blue[i], &above.blue[i], alpha_lo, alpha_hi);
+	}
+#else
+	for (std::size_t i = first; i < first + TILE_SIZE; ++i) {
+		unsigned alpha = above.alpha[i];
+		frame.red[i] = static_cast<uint8_t>(composite_channel(Mode, frame.red[i], above.red[i], alpha));
+		frame.green[i] = static_cast<uint8_t>(composite_channel(Mode, frame.green[i], above.green[i], alpha));
+		frame.blue[i] = static_cast<uint8_t>(composite_channel(Mode, frame.blue[i], above.blue[i], alpha));
+	}
+#endif
+}
+
+template<blend_mode Mode>
+void composite_layer(channels& frame, const layer& above) {
+	for (std::size_t tile = 0; tile < above.touched.size(); ++tile) {
+		if (above.touched[tile]) {
+			composite_tile<Mode>(frame, above, tile * TILE_SIZE);
+		}
+	}
+}
+
+} // anonymous namespace
+
+vlpp::rgba_color vlpp::composite(blend_mode mode, const rgba_color& below, const rgba_color& above) {
+	return rgba_color(
+		static_cast<uint8_t>(composite_channel(mode, below.red, above.red, above.alpha)),
+		static_cast<uint8_t>(composite_channel(mode, below.green, above.green, above.alpha)),
+		static_cast<uint8_t>(composite_channel(mode, below.blue, above.blue, above.alpha)));
+}
+
+//pimpl-class (private members of layer_stack):
+class vlpp::layer_stack::layer_stack_impl {
+	public:
+		explicit layer_stack_impl(std::size_t led_count);
+		std::size_t add_layer(blend_mode mode);
+		void set_mode(std::size_t index, blend_mode mode) {
+			at(index).mode = mode;
+		}
+		void set_led(std::size_t index, uint16_t led_id, const rgba_color& col);
+		void set_leds(std::size_t index, uint16_t first, const rgba_color* colors, std::size_t count);
+		void clear(std::size_t index);
+		void flatten(rgba_color* frame) const;
+		std::size_t size() const {
+			return _size;
+		}
+		std::size_t layers() const {
+			return _layers.size();
+		}
+		
+	private:
+		layer& at(std::size_t index) const;
+		static void store(layer& target, std::size_t led, const rgba_color& col) {
+			target.red[led] = col.red;
+			target.green[led] = col.green;
+			target.blue[led] = col.blue;
+			target.alpha[led] = col.alpha;
+			target.touched[led / TILE_SIZE] |= col.alpha != 0;
+		}
+		
+		std::size_t _size;
+		// the size of the channels, a multiple of TILE_SIZE:
+		std::size_t _padded_size;
+		// the layers don't move, so drawing needs only their own mutex:
+		std::vector<std::unique_ptr<layer>> _layers;
+		// the composited channels (used by flatten only):
+		mutable std::mutex _frame_mutex;
+		mutable channels _frame;
+};
+
+///////////
+
+vlpp::layer_stack::layer_stack(std::size_t led_count):
+	_impl(std::make_shared<layer_stack_impl>(led_count)) {}
+
+std::size_t vlpp::layer_stack::add_layer(blend_mode mode) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::layer_stack");
+	}
+	return _impl->add_layer(mode);
+}
+
+void vlpp::layer_stack::set_mode(std::size_t layer, blend_mode mode) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::layer_stack");
+	}
+	_impl->set_mode(layer, mode);
+}
+
+void vlpp::layer_stack::set_led(std::size_t layer, uint16_t led_id, const rgba_color& col) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::layer_stack");
+	}
+	_impl->set_led(layer, led_id, col);
+}
+
+void vlpp::layer_stack::set_leds(std::size_t layer, uint16_t first, const rgba_color* colors,
+		std::size_t count) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::layer_stack");
+	}
+	_impl->set_leds(layer, first, colors, count);
+}
+
+void vlpp::layer_stack::clear(std::size_t layer) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::layer_stack");
+	}
+	_impl->clear(layer);
+}
+
+void vlpp::layer_stack::flatten(rgba_color* frame) const {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::layer_stack");
+	}
+	_impl->flatten(frame);
+}
+
+void vlpp::layer_stack::flatten(std::vector<rgba_color>& frame) const {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::layer_stack");
+	}
+	frame.resize(_impl->size());
+	_impl->flatten(frame.data());
+}
+
+std::size_t vlpp::layer_stack::size() const {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::layer_stack");
+	}
+	return _impl->size();
+}
+
+std::size_t vlpp::layer_stack::layers() const {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::layer_stack");
+	}
+	return _impl->layers();
+}
+
+///////////
+
+vlpp::layer_stack::layer_stack_impl::layer_stack_impl(std::size_t led_count):
+	_size(led_count),
+	_padded_size((led_count + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE),
+	_frame(_padded_size)
+{
+	if (led_count == 0 || led_count > LED_COUNT) {
+		throw std::invalid_argument("invalid number of LEDs");
+	}
+}
+
+std::size_t vlpp::layer_stack::layer_stack_impl::add_layer(blend_mode mode) {
+	_layers.emplace_back(new layer(_padded_size, mode));
+	return _layers.size() - 1;
+}
+
+layer& vlpp::layer_stack::layer_stack_impl::at(std::size_t index) const {
+	if (index >= _layers.size()) {
+		throw std::out_of_range("invalid layer");
+	}
+	return *_layers[index];
+}
+
+void vlpp::layer_stack::layer_stack_impl::set_led(std::size_t index, uint16_t led_id,
+		const rgba_color& col) {
+	auto& target = at(index);
+	if (led_id >= _size) {
+		throw std::out_of_range("invalid LED");
+	}
+	std::lock_guard<std::mutex> lock(target.mutex);
+	store(target, led_id, col);
+}
+
+void vlpp::layer_stack::layer_stack_impl::set_leds(std::size_t index, uint16_t first,
+		const rgba_color* colors, std::size_t count) {
+	auto& target = at(index);
+	if (count > _size || first > _size - count) {
+		throw std::out_of_range("invalid range");
+	}
+	std::lock_guard<std::mutex> lock(target.mutex);
+	for (std::size_t i = 0; i < count; ++i) {
+		store(target, first + i, colors[i]);
+	}
+}
+
+void vlpp::layer_stack::layer_stack_impl::clear(std::size_t index) {
+	auto& target = at(index);
+	std::lock_guard<std::mutex> lock(target.mutex);
+	// only the alpha-values of the touched tiles can be non-zero:
+	for (std::size_t tile = 0; tile < target.touched.size(); ++tile) {
+		if (target.touched[tile]) {
+			std::fill_n(target.alpha.begin() + static_cast<std::ptrdiff_t>(tile * TILE_SIZE),
+				TILE_SIZE, 0);
+			target.touched[tile] = 0;
+		}
+	}
+}
+
+void vlpp::layer_stack::layer_stack_impl::flatten(rgba_color* frame) const {
+	std::lock_guard<std::mutex> frame_lock(_frame_mutex);
+	std::fill(_frame.red.begin(), _frame.red.end(), 0);
+	std::fill(_frame.green.begin(), _frame.green.end(), 0);
+	std::fill(_frame.blue.begin(), _frame.blue.end(), 0);
+	for (auto& above: _layers) {
+		std::lock_guard<std::mutex> lock(above->mutex);
+		switch (above->mode) {
+			case blend_mode::add:
+				composite_layer<blend_mode::add>(_frame, *above);
+				break;
+			case blend_mode::multiply:
+				composite_layer<blend_mode::multiply>(_frame, *above);
+				break;
+			case blend_mode::screen:
+				composite_layer<blend_mode::screen>(_frame, *above);
+				break;
+			default:
+				composite_layer<blend_mode::over>(_frame, *above);
+		}
+	}
+	
+	// back to the colors of the protocol:
+	std::size_t i = 0;
+#if defined(__SSE2__)
+	const __m128i opaque = _mm_set1_epi8(-1);
+	for (; i + 16 <= _size; i += 16) {
+		__m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&_frame.red[i]));
+		__m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&_frame.green[i]));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&_frame.blue[i]));
+		__m128i rg_lo = _mm_unpacklo_epi8(r, g);
+		__m128i rg_hi = _mm_unpackhi_epi8(r, g);
+		__m128i ba_lo = _mm_unpacklo_epi8(b, opaque);
+		__m128i ba_hi = _mm_unpackhi_epi8(b, opaque);
+		auto out = reinterpret_cast<__m128i*>(frame + i);
+		_mm_storeu_si128(out, _mm_unpacklo_epi16(rg_lo, ba_lo));
+		_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(rg_lo, ba_lo));
+		_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(rg_hi, ba_hi));
+		_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(rg_hi, ba_hi));
+	}
+#endif
+	for (; i < _size; ++i) {
+		frame[i].red = _frame.red[i];
+		frame[i].green = _frame.green[i];
+		frame[i].blue = _frame.blue[i];
+		frame[i].alpha = UINT8_MAX;
+	}
+}
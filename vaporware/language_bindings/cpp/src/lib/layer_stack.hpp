@@ -0,0 +1,187 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LAYER_STACK_HPP
+#define LAYER_STACK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "client.hpp"
+#include "rgba_color.hpp"
+
+namespace vlpp {
+
+/**
+ * @brief How a layer is combined with the layers below it.
+ *
+ * The alpha-value of a color in a layer is its opacity: 0 leaves the layers below
+ * unchanged, 255 applies the mode completely.
+ */
+enum class blend_mode {
+	/**
+	 * @brief the color of the layer covers the ones below
+	 */
+	over,
+	
+	/**
+	 * @brief the color of the layer is added, saturating at 255
+	 */
+	add,
+	
+	/**
+	 * @brief the channels are multiplied, which darkens
+	 */
+	multiply,
+	
+	/**
+	 * @brief the inverted channels are multiplied, which brightens
+	 */
+	screen
+};
+
+/**
+ * @brief Composites a color onto the one below it; this is the reference for layer_stack.
+ *
+ * Every channel is computed in integers and rounded, so the result is exact.
+ *
+ * @param mode the blend-mode of the upper color
+ * @param below the color below, its alpha-value is ignored
+ * @param above the color above
+ * @return the composited color; it is opaque
+ */
+rgba_color composite(blend_mode mode, const rgba_color& below, const rgba_color& above);
+
+/**
+ * @brief Layers of colors that are flattened into one frame.
+ *
+ * Every layer is a framebuffer for all LEDs of the stack with a blend-mode, so several
+ * effects can draw onto the same LEDs, each into its own layer, and flatten() composites
+ * them from the bottom to the top onto black. A new or cleared layer is fully
+ * transparent.
+ *
+ * The layers store the channels in separate arrays, which flatten() blends with SIMD;
+ * it skips the tiles of TILE_SIZE LEDs that were not drawn on since a layer was
+ * cleared.
+ *
+ * Drawing into a layer only locks that layer, so effects in different threads may
+ * draw into their layers and flatten() may run at the same time. Adding layers and
+ * changing their modes is NOT threadsafe.
+ */
+class layer_stack {
+public:
+	/**
+	 * @brief the number of LEDs that are skipped together when they are transparent
+	 */
+	static const std::size_t TILE_SIZE = 64;
+	
+	/**
+	 * @brief the default constructor.
+	 *
+	 * Note that this is not properly constructed afterwards, so any
+	 * attempt of using it will result in a vlpp::uninitialized_error
+	 * beeing thrown.
+	 */
+	layer_stack() = default;
+	
+	/**
+	 * @brief Creates a stack without layers.
+	 * @param led_count the number of LEDs, the stack covers the IDs from 0 to led_count-1
+	 * @throws std::invalid_argument if led_count is 0 or larger than LED_COUNT
+	 */
+	explicit layer_stack(std::size_t led_count);
+	
+	/**
+	 * @brief Adds a transparent layer on top of the others.
+	 * @param mode the blend-mode of the layer
+	 * @return the index of the layer, the bottom one has 0
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	std::size_t add_layer(blend_mode mode = blend_mode::over);
+	
+	/**
+	 * @brief Changes the blend-mode of a layer.
+	 * @throws std::out_of_range if there is no such layer
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_mode(std::size_t layer, blend_mode mode);
+	
+	/**
+	 * @brief Sets the color of an LED in a layer.
+	 * @param layer the index of the layer
+	 * @param led_id the ID of the LED
+	 * @param col the color, its alpha-value is the opacity
+	 * @throws std::out_of_range if there is no such layer or LED
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_led(std::size_t layer, uint16_t led_id, const rgba_color& col);
+	
+	/**
+	 * @brief Sets the colors of consecutive LEDs in a layer.
+	 * @param layer the index of the layer
+	 * @param first the ID of the LED that gets the first color
+	 * @param colors the colors
+	 * @param count the number of colors
+	 * @throws std::out_of_range if there is no such layer or the LEDs exceed the stack
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_leds(std::size_t layer, uint16_t first, const rgba_color* colors, std::size_t count);
+	
+	/**
+	 * @brief Makes a layer fully transparent.
+	 * @throws std::out_of_range if there is no such layer
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void clear(std::size_t layer);
+	
+	/**
+	 * @brief Composites all layers onto black.
+	 * @param frame the opaque colors of all LEDs of the stack
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void flatten(rgba_color* frame) const;
+	
+	/**
+	 * @brief Composites all layers onto black.
+	 * @param frame the opaque colors of all LEDs of the stack; it is resized if necessary
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void flatten(std::vector<rgba_color>& frame) const;
+	
+	/**
+	 * @brief the number of LEDs
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	std::size_t size() const;
+	
+	/**
+	 * @brief the number of layers
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	std::size_t layers() const;
+	
+private:
+	class layer_stack_impl;
+	// see vlpp::client for the reason of the shared_ptr:
+	std::shared_ptr<layer_stack_impl> _impl;
+};
+
+} // namespace vlpp
+
+#endif // LAYER_STACK_HPP
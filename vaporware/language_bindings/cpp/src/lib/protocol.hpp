@@ -0,0 +1,171 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROTOCOL_HPP
+#define PROTOCOL_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace vlpp {
+
+/**
+ * @brief The opcodes of the commands a client sends to the server.
+ *
+ * All IDs are sent as big-endian 16-bit-integers, all colors as RGBA-quadruples.
+ */
+enum class opcodes: uint8_t {
+	/**
+	 * @brief <id> <rgba>: sets one LED
+	 */
+	SET_LED = 0x01,
+	
+	/**
+	 * @brief <token>: authenticates the client
+	 */
+	AUTHENTICATE = 0x02,
+	
+	/**
+	 * @brief <first id> <last id> <rgba>: sets all LEDs in [first, last] to one color
+	 */
+	SET_RANGE = 0x03,
+	
+	/**
+	 * @brief <first id> <last id> <rgba>...: sets the LEDs in [first, last] to consecutive colors
+	 */
+	SET_LEDS = 0x04,
+	
+	/**
+	 * @brief <first id> <run count> (<length> <rgba>)...: sets consecutive runs of LEDs
+	 *
+	 * The first run starts at the first id, every other one right after its
+	 * predecessor; lengths are 16-bit-integers like the IDs and must not be zero.
+	 */
+	SET_RLE = 0x05,
+	
+	/**
+	 * @brief <client time>: asks the server for the time of its clock
+	 *
+	 * This is the only command that is answered: the server immediately sends back
+	 * <PING> <client time> <server time>, see PING_REPLY_SIZE. The client time is
+	 * returned unchanged, so the client may use any clock for it.
+	 */
+	PING = 0x06,
+	
+	/**
+	 * @brief <server time>: executes the commands that were sent before at the given time
+	 *
+	 * The time refers to the monotonic clock of the server, which the client can
+	 * estimate with PING; a time that has passed already is executed right away.
+	 * The server executes none of the following commands before this strobe.
+	 */
+	STROBE_AT = 0xFE,
+	
+	/**
+	 * @brief executes the commands that were sent before
+	 */
+	STROBE = 0xFF
+};
+
+/**
+ * @brief The size of an authentication-token.
+ */
+enum : std::size_t { TOKEN_SIZE = 16 };
+
+/**
+ * @brief The size of a timestamp, a big-endian 64-bit-integer of nanoseconds.
+ *
+ * The timestamps of the server count from an arbitrary, fixed point like
+ * std::chrono::steady_clock.
+ */
+enum : std::size_t { TIMESTAMP_SIZE = 8 };
+
+/**
+ * @brief The size of the answer to a PING.
+ */
+enum : std::size_t { PING_REPLY_SIZE = 1 + 2 * TIMESTAMP_SIZE };
+
+/**
+ * @brief The number of distinct LED-IDs.
+ */
+enum : std::size_t { LED_COUNT = UINT16_MAX + 1 };
+
+/**
+ * @brief The layout of the datagrams in udp-mode.
+ *
+ * Every frame is sent as one or more datagrams of at most DATAGRAM_SIZE bytes, each
+ * consisting of <sequence: 4 bytes> <token-digest: 8 bytes> <flags: 1 byte>, followed
+ * by complete SET_LED, SET_RANGE, SET_LEDS and SET_RLE commands. All datagrams of a frame carry
+ * the same sequence-number; the server strobes after the datagram that has the flag
+ * DATAGRAM_LAST set and drops datagrams that are older than the newest one it has
+ * seen from the same client. There is no AUTHENTICATE, no PING and no STROBE or
+ * STROBE_AT in udp-mode.
+ */
+enum : std::size_t {
+	DATAGRAM_HEADER_SIZE = 13,
+	// the payload of an ethernet-frame, larger datagrams would be fragmented by IP:
+	DATAGRAM_SIZE = 1472
+};
+
+/**
+ * @brief The flags of a datagram.
+ */
+enum : uint8_t { DATAGRAM_LAST = 0x01 };
+
+/**
+ * @brief The digest of a token that authenticates the datagrams in udp-mode.
+ *
+ * This is the 64-bit FNV-1a-hash, which is not a cryptographic hash: just like
+ * the plain token in tcp-mode, it only protects against accidents.
+ */
+inline uint64_t token_digest(const std::string& token) {
+	uint64_t hash = 0xcbf29ce484222325;
+	for (char c: token) {
+		hash ^= static_cast<uint8_t>(c);
+		hash *= 0x100000001b3;
+	}
+	return hash;
+}
+
+/**
+ * @brief Writes a timestamp in the byte-order of the protocol.
+ * @param time the timestamp
+ * @param out the first of TIMESTAMP_SIZE bytes
+ */
+inline void write_timestamp(uint64_t time, char* out) {
+	for (std::size_t i = 0; i < TIMESTAMP_SIZE; ++i) {
+		out[i] = static_cast<char>(time >> (56 - 8 * i));
+	}
+}
+
+/**
+ * @brief Reads a timestamp in the byte-order of the protocol.
+ * @param data the first of TIMESTAMP_SIZE bytes
+ * @return the timestamp
+ */
+inline uint64_t read_timestamp(const char* data) {
+	uint64_t time = 0;
+	for (std::size_t i = 0; i < TIMESTAMP_SIZE; ++i) {
+		time = time << 8 | static_cast<uint8_t>(data[i]);
+	}
+	return time;
+}
+
+} // namespace vlpp
+
+#endif // PROTOCOL_HPP
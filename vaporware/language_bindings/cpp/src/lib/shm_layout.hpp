@@ -0,0 +1,122 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHM_LAYOUT_HPP
+#define SHM_LAYOUT_HPP
+
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "rgba_color.hpp"
+
+// the atomics are shared between processes, which only works if they are lock-free:
+#if ATOMIC_INT_LOCK_FREE != 2 || ATOMIC_LLONG_LOCK_FREE != 2
+	#error "Your platform doesn't support lockfree atomic integers."
+#endif
+
+namespace vlpp {
+namespace shm {
+
+/*
+ * The shared-memory-framebuffer consists of a header followed by SLOT_COUNT slots.
+ * Each slot starts with its sequence-number, followed by led_count colors at offset
+ * SLOT_COLORS_OFFSET. Frame n (starting with 1) is written to slot n % SLOT_COUNT.
+ *
+ * The segment is created by the server and written by a single publisher:
+ *  1. the publisher sets the sequence of the slot to 0 and writes the colors,
+ *  2. it sets the sequence of the slot and then `published` to n,
+ *  3. it increments the doorbell and wakes the server if it sleeps on it.
+ * The server copies the colors of the slot `published` and only accepts them if the
+ * sequence of the slot was n before and after the copy (a seqlock), so a publisher
+ * that overtakes the server can never show a torn frame.
+ */
+enum : uint32_t {
+	MAGIC = 0x564c4642, // "VLFB"
+	VERSION = 1,
+	SLOT_COUNT = 4
+};
+
+enum : std::size_t {
+	CACHE_LINE = 64,
+	SLOT_COLORS_OFFSET = CACHE_LINE
+};
+
+struct header {
+	// written last when the segment is created:
+	std::atomic<uint32_t> magic;
+	uint32_t version;
+	uint32_t led_count;
+	uint32_t slot_count;
+	// the number of the newest complete frame, 0 if there is none yet:
+	alignas(CACHE_LINE) std::atomic<uint64_t> published;
+	// the futex-word, incremented with every frame:
+	std::atomic<uint32_t> doorbell;
+	// the number of consumers that sleep on the doorbell:
+	std::atomic<uint32_t> waiters;
+};
+
+inline std::size_t header_size() {
+	return (sizeof(header) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+}
+
+inline std::size_t slot_size(uint32_t led_count) {
+	return SLOT_COLORS_OFFSET
+		+ (led_count * sizeof(rgba_color) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+}
+
+inline std::size_t segment_size(uint32_t led_count) {
+	return header_size() + SLOT_COUNT * slot_size(led_count);
+}
+
+inline char* slot(header* segment, uint64_t frame) {
+	return reinterpret_cast<char*>(segment) + header_size()
+		+ (frame % SLOT_COUNT) * slot_size(segment->led_count);
+}
+
+inline std::atomic<uint64_t>& slot_sequence(header* segment, uint64_t frame) {
+	return *reinterpret_cast<std::atomic<uint64_t>*>(slot(segment, frame));
+}
+
+inline rgba_color* slot_colors(header* segment, uint64_t frame) {
+	return reinterpret_cast<rgba_color*>(slot(segment, frame) + SLOT_COLORS_OFFSET);
+}
+
+/*
+ * Sleeps until the doorbell differs from expected or the timeout expires.
+ */
+inline void wait_doorbell(header* segment, uint32_t expected, const timespec& timeout) {
+	syscall(SYS_futex, &segment->doorbell, FUTEX_WAIT, expected, &timeout, nullptr, 0);
+}
+
+/*
+ * Wakes all consumers that sleep on the doorbell.
+ */
+inline void ring_doorbell(header* segment) {
+	syscall(SYS_futex, &segment->doorbell, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+} // namespace shm
+} // namespace vlpp
+
+#endif // SHM_LAYOUT_HPP
@@ -0,0 +1,145 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shm_publisher.hpp"
+#include "shm_layout.hpp"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace shm = vlpp::shm;
+
+//pimpl-class (private members of shm_publisher):
+class vlpp::shm_publisher::shm_publisher_impl {
+	public:
+		shm_publisher_impl(const std::string& name);
+		~shm_publisher_impl();
+		std::size_t led_count() const {
+			return _segment->led_count;
+		}
+		rgba_color* frame();
+		void publish();
+		
+	private:
+		shm::header* _segment = nullptr;
+		std::size_t _size = 0;
+		// the number of the last published frame:
+		uint64_t _published;
+		// whether the slot of the next frame is already claimed:
+		bool _writing = false;
+};
+
+///////////
+
+vlpp::shm_publisher::shm_publisher(const std::string& name):
+	_impl(std::make_shared<shm_publisher_impl>(name)) {
+}
+
+std::size_t vlpp::shm_publisher::led_count() const {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::shm_publisher");
+	}
+	return _impl->led_count();
+}
+
+vlpp::rgba_color* vlpp::shm_publisher::frame() {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::shm_publisher");
+	}
+	return _impl->frame();
+}
+
+void vlpp::shm_publisher::set_led(uint16_t led_id, const rgba_color& col) {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::shm_publisher");
+	}
+	if (led_id >= _impl->led_count()) {
+		throw std::out_of_range("LED-ID not in the framebuffer");
+	}
+	_impl->frame()[led_id] = col;
+}
+
+void vlpp::shm_publisher::publish() {
+	if(!_impl){
+		throw vlpp::uninitialized_error("uninitialized use of a vlpp::shm_publisher");
+	}
+	_impl->publish();
+}
+
+///////// now: the private stuff
+
+vlpp::shm_publisher::shm_publisher_impl::shm_publisher_impl(const std::string& name) {
+	int fd = shm_open(name.c_str(), O_RDWR, 0);
+	if (fd < 0) {
+		throw vlpp::connection_failure("cannot open framebuffer " + name);
+	}
+	struct stat info;
+	if (fstat(fd, &info) < 0 || std::size_t(info.st_size) < shm::header_size()) {
+		close(fd);
+		throw vlpp::connection_failure("invalid framebuffer " + name);
+	}
+	_size = std::size_t(info.st_size);
+	void* mapping = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		throw vlpp::connection_failure("cannot map framebuffer " + name);
+	}
+	_segment = static_cast<shm::header*>(mapping);
+	if (_segment->magic.load(std::memory_order_acquire) != shm::MAGIC
+			|| _segment->version != shm::VERSION
+			|| _segment->slot_count != shm::SLOT_COUNT
+			|| _size < shm::segment_size(_segment->led_count)) {
+		munmap(mapping, _size);
+		throw vlpp::connection_failure("invalid framebuffer " + name);
+	}
+	_published = _segment->published.load(std::memory_order_acquire);
+}
+
+vlpp::shm_publisher::shm_publisher_impl::~shm_publisher_impl() {
+	munmap(_segment, _size);
+}
+
+vlpp::rgba_color* vlpp::shm_publisher::shm_publisher_impl::frame() {
+	uint64_t next = _published + 1;
+	if (!_writing) {
+		// invalidate the slot before overwriting it, so the server can't mistake
+		// it for the complete frame from SLOT_COUNT frames ago:
+		shm::slot_sequence(_segment, next).store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		std::memcpy(shm::slot_colors(_segment, next), shm::slot_colors(_segment, _published),
+			_segment->led_count * sizeof(rgba_color));
+		_writing = true;
+	}
+	return shm::slot_colors(_segment, next);
+}
+
+void vlpp::shm_publisher::shm_publisher_impl::publish() {
+	frame();
+	++_published;
+	shm::slot_sequence(_segment, _published).store(_published, std::memory_order_release);
+	_segment->published.store(_published, std::memory_order_release);
+	_writing = false;
+	// pairs with the server incrementing waiters before it checks for new frames:
+	_segment->doorbell.fetch_add(1, std::memory_order_seq_cst);
+	if (_segment->waiters.load(std::memory_order_seq_cst) != 0) {
+		shm::ring_doorbell(_segment);
+	}
+}
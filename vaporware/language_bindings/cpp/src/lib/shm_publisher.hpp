@@ -0,0 +1,110 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SHM_PUBLISHER_HPP
+#define SHM_PUBLISHER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "client.hpp"
+#include "rgba_color.hpp"
+
+namespace vlpp {
+
+/**
+ * @brief Publishes frames through the shared-memory-framebuffer of a local server.
+ *
+ * This is an alternative to vlpp::client for processes on the same host as the
+ * server (see its --shm option): the colors are written directly into a ring of
+ * frames in shared memory, so setting an LED is a plain store and publishing a
+ * frame needs at most one syscall (to wake up the server if it sleeps).
+ *
+ * There must be only one publisher per framebuffer; if the server restarts,
+ * the publisher has to be recreated. Access to the framebuffer is controlled by
+ * the permissions of the shared-memory-object, not by a token.
+ *
+ * Note that using this class is NOT threadsafe.
+ */
+class shm_publisher {
+public:
+	/**
+	 * @brief the default constructor.
+	 *
+	 * Note that this is not properly constructed afterwards, so any
+	 * attempt of using it will result in a vlpp::uninitialized_error
+	 * beeing thrown.
+	 */
+	shm_publisher() = default;
+	
+	/**
+	 * @brief Opens the framebuffer of a server.
+	 * @param name the name of the shared-memory-object, eg "/vaporlight"
+	 * @throws vlpp::connection_failure if the framebuffer doesn't exist or is invalid
+	 */
+	explicit shm_publisher(const std::string& name);
+	
+	shm_publisher(const shm_publisher&) = delete;
+	shm_publisher(shm_publisher&&) = default;
+	
+	shm_publisher &operator=(const shm_publisher&) = delete;
+	shm_publisher &operator=(shm_publisher&&) = default;
+	
+	/**
+	 * @brief the number of LEDs in a frame
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	std::size_t led_count() const;
+	
+	/**
+	 * @brief The colors of the next frame, indexed by the LED-ID.
+	 *
+	 * They initially contain the last published frame; the pointer stays valid
+	 * until the next call of publish().
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	rgba_color* frame();
+	
+	/**
+	 * @brief Sets an LED in the next frame.
+	 * @param led_id the ID of the LED
+	 * @param col the new color
+	 * @throws std::out_of_range if the ID is not in the framebuffer
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void set_led(uint16_t led_id, const rgba_color& col);
+	
+	/**
+	 * @brief Publishes the next frame, the server will display it as soon as possible.
+	 *
+	 * If the server is slower than the publisher, it skips the older frames.
+	 * @throws vlpp::uninitialized_error if this is not initialized correctly
+	 */
+	void publish();
+	
+private:
+	class shm_publisher_impl;
+	// see vlpp::client for the reason of the shared_ptr:
+	std::shared_ptr<shm_publisher_impl> _impl;
+};
+
+} // namespace vlpp
+
+#endif // SHM_PUBLISHER_HPP
@@ -0,0 +1,189 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STATIC_FRAME_HPP
+#define STATIC_FRAME_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "protocol.hpp"
+#include "rgba_color.hpp"
+
+namespace vlpp {
+
+namespace detail {
+
+/*
+ * A sequence of indices for pack-expansions (std::index_sequence is C++14); the
+ * sequences are built by halving, so the depth of the instantiations is only
+ * logarithmic in their length.
+ */
+template<std::size_t... I>
+struct indices {};
+
+template<typename Lhs, typename Rhs>
+struct concat_indices;
+
+template<std::size_t... Lhs, std::size_t... Rhs>
+struct concat_indices<indices<Lhs...>, indices<Rhs...>> {
+	using type = indices<Lhs..., (sizeof...(Lhs) + Rhs)...>;
+};
+
+template<std::size_t N>
+struct make_indices {
+	using type = typename concat_indices<typename make_indices<N / 2>::type,
+		typename make_indices<N - N / 2>::type>::type;
+};
+
+template<>
+struct make_indices<0> {
+	using type = indices<>;
+};
+
+template<>
+struct make_indices<1> {
+	using type = indices<0>;
+};
+
+} // namespace detail
+
+/**
+ * @brief A frame for a set of LEDs that is known at compile time.
+ *
+ * The frame holds the commands exactly as they are sent: one SET_LED per LED, in the
+ * order of the IDs, followed by a STROBE. The opcodes and IDs are computed at compile
+ * time, so setting the colors only stores four bytes per LED at a fixed stride and
+ * vlpp::client::submit() sends the frame without serializing anything.
+ *
+ * SET_LED costs seven bytes per LED; for long runs of consecutive IDs a vlpp::frame_view
+ * with SET_LEDS is smaller on the wire. The LEDs are initialized to the default color.
+ */
+template<uint16_t... Ids>
+class static_frame {
+	static_assert(sizeof...(Ids) > 0, "a static_frame needs at least one LED");
+	
+	enum : std::size_t {
+		RECORD_SIZE = 7,
+		COLOR_OFFSET = 3,
+		FRAME_SIZE = sizeof...(Ids) * RECORD_SIZE + 1
+	};
+	
+public:
+	/**
+	 * @brief the number of LEDs, the slots are numbered in the order of the IDs
+	 */
+	static constexpr std::size_t size() {
+		return sizeof...(Ids);
+	}
+	
+	/**
+	 * @brief the size of the encoded frame in bytes
+	 */
+	static constexpr std::size_t bytes() {
+		return FRAME_SIZE;
+	}
+	
+	/**
+	 * @brief the ID of the LED in a slot
+	 */
+	static constexpr uint16_t id(std::size_t slot) {
+		return IDS[slot];
+	}
+	
+	static_frame(): _data(LAYOUT) {
+		fill(rgba_color());
+	}
+	
+	/**
+	 * @brief Sets the color of the LED in a slot.
+	 * @param slot the slot, smaller than size()
+	 * @param col the new color
+	 */
+	void set(std::size_t slot, const rgba_color& col) noexcept {
+		std::memcpy(&_data[slot * RECORD_SIZE + COLOR_OFFSET], &col, sizeof(col));
+	}
+	
+	/**
+	 * @brief the color of the LED in a slot
+	 */
+	rgba_color get(std::size_t slot) const noexcept {
+		rgba_color col;
+		std::memcpy(&col, &_data[slot * RECORD_SIZE + COLOR_OFFSET], sizeof(col));
+		return col;
+	}
+	
+	/**
+	 * @brief Sets the colors of all LEDs.
+	 * @param colors size() colors, one per slot
+	 */
+	void assign(const rgba_color* colors) noexcept {
+		for (std::size_t slot = 0; slot < size(); ++slot) {
+			set(slot, colors[slot]);
+		}
+	}
+	
+	/**
+	 * @brief Sets all LEDs to the same color.
+	 */
+	void fill(const rgba_color& col) noexcept {
+		for (std::size_t slot = 0; slot < size(); ++slot) {
+			set(slot, col);
+		}
+	}
+	
+	/**
+	 * @brief the encoded frame, bytes() bytes
+	 */
+	const char* data() const noexcept {
+		return _data.data();
+	}
+	
+private:
+	static constexpr uint16_t IDS[sizeof...(Ids)] = {Ids...};
+	
+	static constexpr char byte(std::size_t pos) {
+		return pos == size() * RECORD_SIZE ? static_cast<char>(opcodes::STROBE)
+			: pos % RECORD_SIZE == 0 ? static_cast<char>(opcodes::SET_LED)
+			: pos % RECORD_SIZE == 1 ? static_cast<char>(IDS[pos / RECORD_SIZE] >> 8)
+			: pos % RECORD_SIZE == 2 ? static_cast<char>(IDS[pos / RECORD_SIZE] & 0xff)
+			: static_cast<char>(0);
+	}
+	
+	template<std::size_t... I>
+	static constexpr std::array<char, FRAME_SIZE> layout(detail::indices<I...>) {
+		return {{byte(I)...}};
+	}
+	
+	// the encoded frame without colors, it is initialized at compile time:
+	static const std::array<char, FRAME_SIZE> LAYOUT;
+	
+	std::array<char, FRAME_SIZE> _data;
+};
+
+template<uint16_t... Ids>
+constexpr uint16_t static_frame<Ids...>::IDS[sizeof...(Ids)];
+
+template<uint16_t... Ids>
+const std::array<char, static_frame<Ids...>::FRAME_SIZE> static_frame<Ids...>::LAYOUT =
+	static_frame<Ids...>::layout(typename detail::make_indices<FRAME_SIZE>::type());
+
+} // namespace vlpp
+
+#endif // STATIC_FRAME_HPP
@@ -0,0 +1,104 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stats.hpp"
+
+#include <cmath>
+
+vlpp::histogram::histogram() {
+	_counts.fill(0);
+}
+
+uint64_t vlpp::histogram::lowest_value(std::size_t bucket) noexcept {
+	if (bucket < SUB_BUCKETS) {
+		return bucket;
+	}
+	std::size_t shift = bucket / SUB_BUCKETS - 1;
+	return uint64_t(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+}
+
+uint64_t vlpp::histogram::highest_value(std::size_t bucket) noexcept {
+	if (bucket + 1 == BUCKET_COUNT) {
+		return UINT64_MAX;
+	}
+	return lowest_value(bucket + 1) - 1;
+}
+
+uint64_t vlpp::histogram::count() const {
+	uint64_t total = 0;
+	for (auto count: _counts) {
+		total += count;
+	}
+	return total;
+}
+
+uint64_t vlpp::histogram::percentile(double fraction) const {
+	uint64_t total = count();
+	if (!total) {
+		return 0;
+	}
+	// the rank of the value, counted from 1:
+	auto rank = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(total)));
+	if (rank == 0) {
+		rank = 1;
+	}
+	uint64_t seen = 0;
+	for (std::size_t i = 0; i < BUCKET_COUNT; ++i) {
+		seen += _counts[i];
+		if (seen >= rank) {
+			return highest_value(i);
+		}
+	}
+	return max();
+}
+
+uint64_t vlpp::histogram::max() const {
+	for (std::size_t i = BUCKET_COUNT; i > 0; --i) {
+		if (_counts[i - 1]) {
+			return highest_value(i - 1);
+		}
+	}
+	return 0;
+}
+
+double vlpp::histogram::mean() const {
+	double sum = 0;
+	uint64_t total = 0;
+	for (std::size_t i = 0; i < BUCKET_COUNT; ++i) {
+		if (_counts[i]) {
+			double middle = (static_cast<double>(lowest_value(i))
+				+ static_cast<double>(highest_value(i))) / 2;
+			sum += middle * static_cast<double>(_counts[i]);
+			total += _counts[i];
+		}
+	}
+	return total ? sum / static_cast<double>(total) : 0;
+}
+
+vlpp::atomic_histogram::atomic_histogram() {
+	for (auto& count: _counts) {
+		count.store(0, std::memory_order_relaxed);
+	}
+}
+
+vlpp::histogram vlpp::atomic_histogram::snapshot() const {
+	histogram result;
+	for (std::size_t i = 0; i < histogram::BUCKET_COUNT; ++i) {
+		result._counts[i] = _counts[i].load(std::memory_order_relaxed);
+	}
+	return result;
+}
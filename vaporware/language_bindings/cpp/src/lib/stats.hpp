@@ -0,0 +1,183 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace vlpp {
+
+/**
+ * @brief A histogram with buckets of constant relative precision, e.g. for latencies.
+ *
+ * Like an HDR-histogram, the values below SUB_BUCKETS get one bucket each and every
+ * power of two above is split into SUB_BUCKETS linear buckets, so a bucket is never
+ * wider than 1/16 of its values and the whole range of uint64_t fits into BUCKET_COUNT
+ * buckets.
+ */
+class histogram {
+public:
+	enum : std::size_t {
+		SUB_BUCKET_BITS = 4,
+		SUB_BUCKETS = 1 << SUB_BUCKET_BITS,
+		BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS
+	};
+	
+	/**
+	 * @brief Creates an empty histogram.
+	 */
+	histogram();
+	
+	/**
+	 * @brief the index of the bucket that counts a value
+	 */
+	static std::size_t bucket(uint64_t value) noexcept {
+		if (value < SUB_BUCKETS) {
+			return static_cast<std::size_t>(value);
+		}
+		// the position of the highest bit selects the power of two, the next
+		// SUB_BUCKET_BITS bits select the bucket within it:
+		std::size_t exponent = 63 - static_cast<std::size_t>(__builtin_clzll(value));
+		std::size_t shift = exponent - SUB_BUCKET_BITS;
+		return (shift + 1) * SUB_BUCKETS + static_cast<std::size_t>(value >> shift) - SUB_BUCKETS;
+	}
+	
+	/**
+	 * @brief the smallest value that is counted by a bucket
+	 */
+	static uint64_t lowest_value(std::size_t bucket) noexcept;
+	
+	/**
+	 * @brief the largest value that is counted by a bucket
+	 */
+	static uint64_t highest_value(std::size_t bucket) noexcept;
+	
+	/**
+	 * @brief the number of values in a bucket
+	 */
+	uint64_t count(std::size_t bucket) const {
+		return _counts[bucket];
+	}
+	
+	/**
+	 * @brief the number of values in all buckets
+	 */
+	uint64_t count() const;
+	
+	/**
+	 * @brief Finds the value that is not exceeded by a fraction of the values.
+	 * @param fraction the fraction in [0, 1], e.g. 0.99 for the 99th percentile
+	 * @return the highest value of the bucket that contains the percentile, 0 if
+	 *         the histogram is empty
+	 */
+	uint64_t percentile(double fraction) const;
+	
+	/**
+	 * @brief the highest value of the highest bucket that is not empty, 0 if there is none
+	 */
+	uint64_t max() const;
+	
+	/**
+	 * @brief the mean of the values, assuming that they lie in the middle of their buckets
+	 */
+	double mean() const;
+	
+private:
+	friend class atomic_histogram;
+	std::array<uint64_t, BUCKET_COUNT> _counts;
+};
+
+/**
+ * @brief A histogram that one or more threads update and others read at the same time.
+ *
+ * Recording a value is a single relaxed atomic increment, without any locks.
+ * A snapshot reads every bucket once; it is consistent per bucket, but values that
+ * are recorded while it is taken may or may not be included.
+ */
+class atomic_histogram {
+public:
+	/**
+	 * @brief Creates an empty histogram.
+	 */
+	atomic_histogram();
+	
+	atomic_histogram(const atomic_histogram&) = delete;
+	atomic_histogram &operator=(const atomic_histogram&) = delete;
+	
+	/**
+	 * @brief Counts a value.
+	 */
+	void record(uint64_t value) noexcept {
+		_counts[histogram::bucket(value)].fetch_add(1, std::memory_order_relaxed);
+	}
+	
+	/**
+	 * @brief Copies the current counts.
+	 */
+	histogram snapshot() const;
+	
+private:
+	std::array<std::atomic<uint64_t>, histogram::BUCKET_COUNT> _counts;
+};
+
+/**
+ * @brief What a vlpp::client has done since it was created.
+ */
+struct client_stats {
+	/**
+	 * @brief the number of frames that were sent by flush() or submit()
+	 */
+	uint64_t frames = 0;
+	
+	/**
+	 * @brief the number of commands that were sent, including the strobes
+	 */
+	uint64_t records = 0;
+	
+	/**
+	 * @brief the number of bytes that were passed to the kernel
+	 */
+	uint64_t bytes_sent = 0;
+	
+	/**
+	 * @brief the number of bytes that the encoding saved
+	 *
+	 * This compares the commands that were sent with one SET_LED, SET_RANGE or
+	 * SET_LEDS per call of set_led(), set_led_range() and set_leds(), so it includes
+	 * merged ranges, run-length encoding, compaction and delta-mode. It is negative if
+	 * the encoding needed more bytes, e.g. after merging neighbours into a longer span.
+	 */
+	int64_t bytes_saved = 0;
+	
+	/**
+	 * @brief the number of write-syscalls (and datagrams) that sent the frames
+	 */
+	uint64_t writes = 0;
+	
+	/**
+	 * @brief how long flush() and submit() blocked the caller, in nanoseconds
+	 */
+	histogram flush_latency;
+};
+
+} // namespace vlpp
+
+#endif // STATS_HPP
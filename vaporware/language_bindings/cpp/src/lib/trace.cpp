@@ -0,0 +1,211 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+struct event {
+	std::atomic<const char*> name;
+	std::atomic<int64_t> begin;
+	std::atomic<int64_t> end;
+};
+
+/*
+ * The events of one thread. Only that thread writes them, like a seqlock: it
+ * increments started before it overwrites the oldest event and written after
+ * that, so a reader knows which events it may have read while they changed.
+ */
+struct ring {
+	explicit ring(std::size_t id): id(id), name(nullptr), started(0), written(0),
+		events(new event[vlpp::trace::RING_SIZE]()) {}
+	
+	const std::size_t id;
+	std::atomic<const char*> name;
+	std::atomic<uint64_t> started;
+	std::atomic<uint64_t> written;
+	std::unique_ptr<event[]> events;
+};
+
+struct registry {
+	std::mutex mutex;
+	// the rings outlive their threads, so their events can still be written:
+	std::vector<std::shared_ptr<ring>> rings;
+	std::string exit_path;
+};
+
+registry& get_registry() {
+	static registry instance;
+	return instance;
+}
+
+ring& local_ring() {
+	thread_local std::shared_ptr<ring> local;
+	if (!local) {
+		auto& reg = get_registry();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		local = std::make_shared<ring>(reg.rings.size() + 1);
+		reg.rings.push_back(local);
+	}
+	return *local;
+}
+
+int64_t nanoseconds(vlpp::trace::clock::time_point time) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+void write_string(std::ostream& stream, const char* str) {
+	stream << '"';
+	for (; *str; ++str) {
+		if (*str == '"' || *str == '\\') {
+			stream << '\\';
+		}
+		stream << *str;
+	}
+	stream << '"';
+}
+
+void dump_at_exit_handler() {
+	auto& reg = get_registry();
+	std::string path;
+	{
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		path = reg.exit_path;
+	}
+	try {
+		vlpp::trace::dump(path);
+	}
+	catch (std::exception& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+	}
+}
+
+} // anonymous namespace
+
+void vlpp::trace::record(const char* name, clock::time_point begin, clock::time_point end) noexcept {
+	ring* r;
+	try {
+		r = &local_ring();
+	}
+	catch (...) {
+		// without a ring the event is lost, which is better than terminating:
+		return;
+	}
+	uint64_t n = r->written.load(std::memory_order_relaxed);
+	r->started.store(n + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	event& e = r->events[n % RING_SIZE];
+	e.name.store(name, std::memory_order_relaxed);
+	e.begin.store(nanoseconds(begin), std::memory_order_relaxed);
+	e.end.store(nanoseconds(end), std::memory_order_relaxed);
+	r->written.store(n + 1, std::memory_order_release);
+}
+
+void vlpp::trace::set_thread_name(const char* name) {
+	local_ring().name.store(name, std::memory_order_relaxed);
+}
+
+void vlpp::trace::dump(std::ostream& stream) {
+	std::vector<std::shared_ptr<ring>> rings;
+	{
+		auto& reg = get_registry();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		rings = reg.rings;
+	}
+	struct copy {
+		const char* name;
+		int64_t begin;
+		int64_t end;
+	};
+	std::vector<copy> events;
+	const auto pid = getpid();
+	const char* separator = "";
+	auto flags = stream.flags();
+	auto precision = stream.precision();
+	stream << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+	for (auto& r: rings) {
+		uint64_t written = r->written.load(std::memory_order_acquire);
+		uint64_t first = written > RING_SIZE ? written - RING_SIZE : 0;
+		events.clear();
+		for (uint64_t i = first; i < written; ++i) {
+			const event& e = r->events[i % RING_SIZE];
+			events.push_back({e.name.load(std::memory_order_relaxed),
+				e.begin.load(std::memory_order_relaxed), e.end.load(std::memory_order_relaxed)});
+		}
+		// the events that the thread started to overwrite meanwhile are discarded:
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t started = r->started.load(std::memory_order_relaxed);
+		uint64_t valid = started > RING_SIZE ? started - RING_SIZE : 0;
+		
+		if (const char* name = r->name.load(std::memory_order_relaxed)) {
+			stream << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+			       << ",\"tid\":" << r->id << ",\"args\":{\"name\":";
+			write_string(stream, name);
+			stream << "}}";
+			separator = ",\n";
+		}
+		for (uint64_t i = std::max(first, valid); i < written; ++i) {
+			const copy& e = events[i - first];
+			stream << separator << "{\"name\":";
+			write_string(stream, e.name);
+			stream << ",\"ph\":\"X\",\"ts\":" << static_cast<double>(e.begin) / 1000
+			       << ",\"dur\":" << static_cast<double>(e.end - e.begin) / 1000
+			       << ",\"pid\":" << pid << ",\"tid\":" << r->id << "}";
+			separator = ",\n";
+		}
+	}
+	stream << "\n]}" << std::endl;
+	stream.flags(flags);
+	stream.precision(precision);
+}
+
+void vlpp::trace::dump(const std::string& path) {
+	std::ofstream file(path);
+	if (!file) {
+		throw std::runtime_error("can't open the trace-file “" + path + "”");
+	}
+	dump(file);
+	if (!file) {
+		throw std::runtime_error("can't write the trace-file “" + path + "”");
+	}
+}
+
+void vlpp::trace::dump_at_exit(const std::string& path) {
+	auto& reg = get_registry();
+	bool first;
+	{
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		first = reg.exit_path.empty();
+		reg.exit_path = path;
+	}
+	if (first) {
+		std::atexit(dump_at_exit_handler);
+	}
+}
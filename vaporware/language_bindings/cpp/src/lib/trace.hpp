@@ -0,0 +1,131 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+/**
+ * @file
+ * @brief Records when the stages of the render-pipeline begin and end.
+ *
+ * Every thread writes its events into its own ring-buffer without any locks, the
+ * oldest events are overwritten once it is full. The events can be written as
+ * Chrome-trace-JSON at any time (load it in chrome://tracing or ui.perfetto.dev).
+ *
+ * The library records its own stages only if it is built with the cmake-option
+ * BUILD_TRACING, which defines VLPP_TRACING; otherwise VLPP_TRACE_SCOPE() expands
+ * to nothing and the traces stay empty.
+ */
+
+namespace vlpp {
+namespace trace {
+
+/**
+ * @brief The number of events that every thread keeps.
+ */
+enum : std::size_t { RING_SIZE = 1 << 16 };
+
+/**
+ * @brief The clock of the timestamps.
+ */
+using clock = std::chrono::steady_clock;
+
+/**
+ * @brief Records a stage of the current thread.
+ * @param name the name of the stage; it must stay valid until the trace is written,
+ *        so use a string-literal
+ * @param begin when the stage began
+ * @param end when the stage ended
+ */
+void record(const char* name, clock::time_point begin, clock::time_point end) noexcept;
+
+/**
+ * @brief Names the current thread in the trace.
+ * @param name the name; it must stay valid until the trace is written
+ */
+void set_thread_name(const char* name);
+
+/**
+ * @brief Writes the recorded events of all threads as Chrome-trace-JSON.
+ *
+ * This may be called while other threads record events; events that are
+ * overwritten while they are written are left out.
+ * @param stream the stream to write to
+ */
+void dump(std::ostream& stream);
+
+/**
+ * @brief Writes the recorded events of all threads into a file.
+ * @param path the path of the file
+ * @throws std::runtime_error if the file can't be written
+ */
+void dump(const std::string& path);
+
+/**
+ * @brief Writes the recorded events into a file when the program exits normally.
+ *
+ * Errors are reported to std::cerr. Only the last path is used if this is called
+ * more than once.
+ * @param path the path of the file
+ */
+void dump_at_exit(const std::string& path);
+
+/**
+ * @brief Records the time from its construction to its destruction as a stage.
+ */
+class scope {
+public:
+	/**
+	 * @param name the name of the stage; it must stay valid until the trace is written
+	 */
+	explicit scope(const char* name) noexcept: _name(name), _begin(clock::now()) {}
+	
+	~scope() {
+		record(_name, _begin, clock::now());
+	}
+	
+	scope(const scope&) = delete;
+	scope &operator=(const scope&) = delete;
+	
+private:
+	const char* _name;
+	clock::time_point _begin;
+};
+
+} // namespace trace
+} // namespace vlpp
+
+#define VLPP_TRACE_CONCAT_IMPL(a, b) a##b
+#define VLPP_TRACE_CONCAT(a, b) VLPP_TRACE_CONCAT_IMPL(a, b)
+
+#ifdef VLPP_TRACING
+/**
+ * @brief Records the rest of the enclosing block as a stage with the given name.
+ */
+#define VLPP_TRACE_SCOPE(name) \
+	::vlpp::trace::scope VLPP_TRACE_CONCAT(vlpp_trace_scope_, __LINE__)(name)
+#else
+#define VLPP_TRACE_SCOPE(name) static_cast<void>(0)
+#endif
+
+#endif // TRACE_HPP
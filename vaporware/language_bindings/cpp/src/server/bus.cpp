@@ -0,0 +1,214 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "bus.hpp"
+
+#include <cerrno>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+// see led-boards/config.h and led-boards/command.c:
+enum : uint8_t {
+	START_MARK = 0x55,
+	ESCAPE_MARK = 0x54,
+	CMD_BROADCAST = 0xfd,
+	CMD_STROBE = 0xfe
+};
+
+/*
+ * Appends a byte and escapes it, if the boards would misinterpret it.
+ */
+void append_escaped(std::vector<char>& out, uint8_t byte) {
+	if (byte == ESCAPE_MARK || byte == START_MARK) {
+		out.push_back(static_cast<char>(ESCAPE_MARK));
+		out.push_back(static_cast<char>(byte - ESCAPE_MARK));
+	}
+	else {
+		out.push_back(static_cast<char>(byte));
+	}
+}
+
+std::system_error last_error(const std::string& what) {
+	return std::system_error(errno, std::system_category(), what);
+}
+
+/*
+ * Disables all the processing that the tty-layer does by default.
+ */
+void make_raw(int fd, speed_t speed) {
+	termios attributes;
+	if (tcgetattr(fd, &attributes)) {
+		throw last_error("tcgetattr");
+	}
+	cfmakeraw(&attributes);
+	if (speed) {
+		cfsetispeed(&attributes, speed);
+		cfsetospeed(&attributes, speed);
+	}
+	if (tcsetattr(fd, TCSANOW, &attributes)) {
+		throw last_error("tcsetattr");
+	}
+}
+
+speed_t to_speed(unsigned baud_rate) {
+	static const std::map<unsigned, speed_t> speeds = {
+		{9600, B9600}, {19200, B19200}, {38400, B38400}, {57600, B57600},
+		{115200, B115200}, {230400, B230400}, {460800, B460800}, {500000, B500000},
+		{921600, B921600}, {1000000, B1000000}
+	};
+	auto it = speeds.find(baud_rate);
+	if (it == speeds.end()) {
+		throw std::invalid_argument("unsupported baud-rate: " + std::to_string(baud_rate));
+	}
+	return it->second;
+}
+
+} // anonymous namespace
+
+bus::bus(boost::asio::io_service& io_service, const std::string& device, unsigned baud_rate,
+		const std::vector<uint16_t>& addresses): _device(io_service) {
+	for (auto address: addresses) {
+		if (address >= CMD_BROADCAST) {
+			throw std::invalid_argument("invalid module-address: " + std::to_string(address));
+		}
+		module tmp;
+		tmp.address = static_cast<uint8_t>(address);
+		tmp.channels.fill(0);
+		tmp.dirty = true;
+		_modules.push_back(tmp);
+	}
+	if (device == "pty") {
+		open_pty();
+	}
+	else {
+		open_device(device, baud_rate);
+	}
+}
+
+bus::~bus() {
+	if (_slave_fd >= 0) {
+		close(_slave_fd);
+	}
+}
+
+const std::string& bus::name() const {
+	return _name;
+}
+
+std::size_t bus::module_count() const {
+	return _modules.size();
+}
+
+void bus::set_channel(std::size_t module, std::size_t channel, uint8_t value) {
+	auto& mod = _modules[module];
+	if (mod.channels[channel] != value) {
+		mod.channels[channel] = value;
+		mod.dirty = true;
+	}
+}
+
+void bus::strobe() {
+	if (_writing) {
+		_strobe_pending = true;
+		return;
+	}
+	render();
+	start_write();
+}
+
+std::size_t bus::bytes_written() const {
+	return _bytes_written;
+}
+
+void bus::open_device(const std::string& device, unsigned baud_rate) {
+	auto speed = to_speed(baud_rate);
+	int fd = open(device.c_str(), O_RDWR | O_NOCTTY);
+	if (fd < 0) {
+		throw last_error("cannot open " + device);
+	}
+	_device.assign(fd);
+	make_raw(fd, speed);
+	_name = device;
+}
+
+void bus::open_pty() {
+	int fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if (fd < 0) {
+		throw last_error("posix_openpt");
+	}
+	_device.assign(fd);
+	if (grantpt(fd) || unlockpt(fd)) {
+		throw last_error("cannot unlock the pty");
+	}
+	_name = ptsname(fd);
+	_slave_fd = open(_name.c_str(), O_RDWR | O_NOCTTY);
+	if (_slave_fd < 0) {
+		throw last_error("cannot open " + _name);
+	}
+	// the line-discipline works on the slave-side:
+	make_raw(_slave_fd, 0);
+}
+
+void bus::render() {
+	bool changed = false;
+	for (auto& mod: _modules) {
+		if (!mod.dirty) {
+			continue;
+		}
+		_out.push_back(static_cast<char>(START_MARK));
+		append_escaped(_out, mod.address);
+		for (auto value: mod.channels) {
+			append_escaped(_out, value);
+		}
+		mod.dirty = false;
+		changed = true;
+	}
+	if (changed) {
+		_out.push_back(static_cast<char>(START_MARK));
+		_out.push_back(static_cast<char>(CMD_STROBE));
+	}
+}
+
+void bus::start_write() {
+	if (_out.empty()) {
+		return;
+	}
+	_writing = true;
+	boost::asio::async_write(_device, boost::asio::buffer(_out),
+		[this](const boost::system::error_code& e, std::size_t length) {
+			_writing = false;
+			_bytes_written += length;
+			_out.clear();
+			if (e) {
+				std::cerr << "Error: cannot write to " << _name << ": " << e.message() << std::endl;
+			}
+			if (_strobe_pending) {
+				_strobe_pending = false;
+				render();
+				start_write();
+			}
+		});
+}
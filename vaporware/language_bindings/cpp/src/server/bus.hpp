@@ -0,0 +1,114 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef BUS_HPP
+#define BUS_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+/**
+ * @brief The number of channels of an LED-board (see led-boards/config.h).
+ */
+enum : std::size_t { MODULE_LENGTH = 16 };
+
+/**
+ * @brief A serial bus (RS485) with some LED-boards attached to it.
+ *
+ * The bus keeps the channel-values of all its boards and sends them with the
+ * framing the boards expect (see led-boards/usart.c): every command starts with
+ * START_MARK, the bytes 0x54 and 0x55 are escaped with ESCAPE_MARK.
+ *
+ * Writes never queue up: if a strobe arrives while the last frame is still being
+ * written, the bus sends the latest state as soon as the device is ready again.
+ */
+class bus {
+public:
+	/**
+	 * @brief Opens a serial device.
+	 * @param io_service the io_service that will run the writes
+	 * @param device the path of the device or "pty" to create a pseudo-terminal
+	 * @param baud_rate the baud-rate of the device (ignored for pseudo-terminals)
+	 * @param addresses the addresses of the boards on this bus
+	 * @throws std::invalid_argument if an address or the baud-rate is invalid
+	 * @throws std::system_error if the device cannot be opened
+	 */
+	bus(boost::asio::io_service& io_service, const std::string& device, unsigned baud_rate,
+		const std::vector<uint16_t>& addresses);
+	
+	~bus();
+	
+	bus(const bus&) = delete;
+	bus &operator=(const bus&) = delete;
+	
+	/**
+	 * @brief the path of the device; for pseudo-terminals the path of the slave
+	 */
+	const std::string& name() const;
+	
+	/**
+	 * @brief the number of boards on this bus
+	 */
+	std::size_t module_count() const;
+	
+	/**
+	 * @brief Sets the value of a channel; this will be sent with the next strobe.
+	 * @param module the index of the board on this bus
+	 * @param channel the channel of the board
+	 * @param value the new brightness
+	 */
+	void set_channel(std::size_t module, std::size_t channel, uint8_t value);
+	
+	/**
+	 * @brief Sends all changed boards and lets them display their new values.
+	 */
+	void strobe();
+	
+	/**
+	 * @brief the total number of bytes written to the device
+	 */
+	std::size_t bytes_written() const;
+	
+private:
+	struct module {
+		uint8_t address;
+		std::array<uint8_t, MODULE_LENGTH> channels;
+		bool dirty;
+	};
+	
+	void open_device(const std::string& device, unsigned baud_rate);
+	void open_pty();
+	void render();
+	void start_write();
+	
+	boost::asio::posix::stream_descriptor _device;
+	// pseudo-terminals only: keeps the slave open, so that readers may come and go:
+	int _slave_fd = -1;
+	std::string _name;
+	std::vector<module> _modules;
+	std::vector<char> _out;
+	bool _writing = false;
+	bool _strobe_pending = false;
+	std::size_t _bytes_written = 0;
+};
+
+#endif // BUS_HPP
@@ -0,0 +1,146 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "decoder.hpp"
+
+#include "../lib/protocol.hpp"
+
+using vlpp::opcodes;
+
+namespace {
+
+enum : std::size_t {
+	ID_SIZE = 2,
+	COLOR_SIZE = 4,
+	SET_LED_SIZE = 1 + ID_SIZE + COLOR_SIZE,
+	RANGE_HEADER_SIZE = 1 + 2 * ID_SIZE,
+	RUN_SIZE = ID_SIZE + COLOR_SIZE
+};
+
+uint16_t read_id(const char* data) {
+	return static_cast<uint16_t>((static_cast<uint8_t>(data[0]) << 8) | static_cast<uint8_t>(data[1]));
+}
+
+vlpp::rgba_color read_color(const char* data) {
+	return {static_cast<uint8_t>(data[0]), static_cast<uint8_t>(data[1]),
+		static_cast<uint8_t>(data[2]), static_cast<uint8_t>(data[3])};
+}
+
+/*
+ * Reads the IDs of a range-header and validates them.
+ */
+std::size_t range_length(const char* header, uint16_t& first, uint16_t& last) {
+	first = read_id(header + 1);
+	last = read_id(header + 1 + ID_SIZE);
+	if (last < first) {
+		throw protocol_error("invalid range");
+	}
+	return std::size_t(last) - first + 1;
+}
+
+} // anonymous namespace
+
+std::size_t decode(const char* data, std::size_t size, command_handler& handler) {
+	std::size_t pos = 0;
+	while (pos < size) {
+		const char* cmd = data + pos;
+		std::size_t available = size - pos;
+		uint16_t first;
+		uint16_t last;
+		switch (static_cast<opcodes>(cmd[0])) {
+			case opcodes::SET_LED:
+				if (available < SET_LED_SIZE) {
+					return pos;
+				}
+				handler.set_led(read_id(cmd + 1), read_color(cmd + 1 + ID_SIZE));
+				pos += SET_LED_SIZE;
+				break;
+			case opcodes::AUTHENTICATE:
+				if (available < 1 + vlpp::TOKEN_SIZE) {
+					return pos;
+				}
+				handler.authenticate(std::string(cmd + 1, vlpp::TOKEN_SIZE));
+				pos += 1 + vlpp::TOKEN_SIZE;
+				break;
+			case opcodes::SET_RANGE:
+				if (available < RANGE_HEADER_SIZE + COLOR_SIZE) {
+					return pos;
+				}
+				range_length(cmd, first, last);
+				handler.set_range(first, last, read_color(cmd + RANGE_HEADER_SIZE));
+				pos += RANGE_HEADER_SIZE + COLOR_SIZE;
+				break;
+			case opcodes::SET_LEDS: {
+				if (available < RANGE_HEADER_SIZE) {
+					return pos;
+				}
+				std::size_t count = range_length(cmd, first, last);
+				if (available < RANGE_HEADER_SIZE + count * COLOR_SIZE) {
+					return pos;
+				}
+				handler.set_leds(first,
+					reinterpret_cast<const vlpp::rgba_color*>(cmd + RANGE_HEADER_SIZE), count);
+				pos += RANGE_HEADER_SIZE + count * COLOR_SIZE;
+				break;
+			}
+			case opcodes::SET_RLE: {
+				if (available < RANGE_HEADER_SIZE) {
+					return pos;
+				}
+				std::size_t runs = read_id(cmd + 1 + ID_SIZE);
+				if (available < RANGE_HEADER_SIZE + runs * RUN_SIZE) {
+					return pos;
+				}
+				// every run is passed on as a range:
+				std::size_t run_first = read_id(cmd + 1);
+				const char* run = cmd + RANGE_HEADER_SIZE;
+				for (std::size_t i = 0; i < runs; ++i, run += RUN_SIZE) {
+					std::size_t length = read_id(run);
+					if (length == 0 || run_first + length > vlpp::LED_COUNT) {
+						throw protocol_error("invalid run");
+					}
+					handler.set_range(static_cast<uint16_t>(run_first),
+						static_cast<uint16_t>(run_first + length - 1), read_color(run + ID_SIZE));
+					run_first += length;
+				}
+				pos += RANGE_HEADER_SIZE + runs * RUN_SIZE;
+				break;
+			}
+			case opcodes::STROBE:
+				handler.strobe();
+				pos += 1;
+				break;
+			case opcodes::STROBE_AT:
+				if (available < 1 + vlpp::TIMESTAMP_SIZE) {
+					return pos;
+				}
+				handler.strobe_at(vlpp::read_timestamp(cmd + 1));
+				return pos + 1 + vlpp::TIMESTAMP_SIZE;
+			case opcodes::PING:
+				if (available < 1 + vlpp::TIMESTAMP_SIZE) {
+					return pos;
+				}
+				handler.ping(vlpp::read_timestamp(cmd + 1));
+				pos += 1 + vlpp::TIMESTAMP_SIZE;
+				break;
+			default:
+				throw protocol_error("unknown opcode");
+		}
+	}
+	return pos;
+}
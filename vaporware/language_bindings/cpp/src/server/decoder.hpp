@@ -0,0 +1,103 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DECODER_HPP
+#define DECODER_HPP
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "../lib/rgba_color.hpp"
+
+/**
+ * @brief Interface for the receivers of decoded commands.
+ */
+class command_handler {
+public:
+	virtual ~command_handler() = default;
+	
+	/**
+	 * @brief called for AUTHENTICATE
+	 * @param token the token
+	 */
+	virtual void authenticate(const std::string& token) = 0;
+	
+	/**
+	 * @brief called for SET_LED
+	 * @param id the ID of the LED
+	 * @param col the color
+	 */
+	virtual void set_led(uint16_t id, const vlpp::rgba_color& col) = 0;
+	
+	/**
+	 * @brief called for SET_RANGE and for every run of SET_RLE
+	 * @param first the first ID
+	 * @param last the last ID, never smaller than first
+	 * @param col the color
+	 */
+	virtual void set_range(uint16_t first, uint16_t last, const vlpp::rgba_color& col) = 0;
+	
+	/**
+	 * @brief called for SET_LEDS
+	 * @param first the ID of the first LED
+	 * @param colors the colors; they point into the decoded data
+	 * @param count the number of colors
+	 */
+	virtual void set_leds(uint16_t first, const vlpp::rgba_color* colors, std::size_t count) = 0;
+	
+	/**
+	 * @brief called for STROBE
+	 */
+	virtual void strobe() = 0;
+	
+	/**
+	 * @brief called for STROBE_AT
+	 * @param time the time of the server's monotonic clock in nanoseconds
+	 */
+	virtual void strobe_at(uint64_t time) = 0;
+	
+	/**
+	 * @brief called for PING
+	 * @param client_time the time of the client, which must be sent back unchanged
+	 */
+	virtual void ping(uint64_t client_time) = 0;
+};
+
+/**
+ * @brief Exception that will be thrown if a client violates the protocol.
+ */
+class protocol_error: public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief Decodes as many complete commands as possible.
+ *
+ * Decoding stops right after a STROBE_AT, so that the handler can hold back the
+ * following commands until the strobe has been executed.
+ * @param data the received data
+ * @param size the size of the data
+ * @param handler receives the commands
+ * @return the number of bytes that were consumed; the rest is an incomplete command
+ * @throws protocol_error if the data contains an invalid command
+ */
+std::size_t decode(const char* data, std::size_t size, command_handler& handler);
+
+#endif // DECODER_HPP
@@ -0,0 +1,62 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "led_map.hpp"
+
+led_map::led_map(std::vector<std::unique_ptr<bus>> buses): _buses(std::move(buses)) {
+	for (auto& b: _buses) {
+		for (std::size_t i = 0; i < b->module_count(); ++i) {
+			_modules.push_back({b.get(), i});
+		}
+	}
+}
+
+std::size_t led_map::led_count() const {
+	return _modules.size() * LEDS_PER_MODULE;
+}
+
+void led_map::set_led(uint16_t id, const vlpp::rgba_color& col) {
+	std::size_t module = id / LEDS_PER_MODULE;
+	if (module >= _modules.size()) {
+		return;
+	}
+	auto& loc = _modules[module];
+	std::size_t channel = (id % LEDS_PER_MODULE) * CHANNELS_PER_LED;
+	// scale with rounding, so that alpha = 255 leaves the values untouched:
+	auto scale = [&col](uint8_t value) {
+		return static_cast<uint8_t>((value * col.alpha + UINT8_MAX / 2) / UINT8_MAX);
+	};
+	loc.target->set_channel(loc.module, channel, scale(col.red));
+	loc.target->set_channel(loc.module, channel + 1, scale(col.green));
+	loc.target->set_channel(loc.module, channel + 2, scale(col.blue));
+}
+
+void led_map::strobe() {
+	for (auto& b: _buses) {
+		b->strobe();
+	}
+	++_strobes;
+}
+
+const std::vector<std::unique_ptr<bus>>& led_map::buses() const {
+	return _buses;
+}
+
+std::size_t led_map::strobes() const {
+	return _strobes;
+}
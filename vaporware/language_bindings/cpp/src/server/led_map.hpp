@@ -0,0 +1,94 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LED_MAP_HPP
+#define LED_MAP_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../lib/rgba_color.hpp"
+
+#include "bus.hpp"
+
+/**
+ * @brief The number of channels that make up one rgb-LED.
+ */
+enum : std::size_t { CHANNELS_PER_LED = 3 };
+
+/**
+ * @brief The number of rgb-LEDs on one board.
+ */
+enum : std::size_t { LEDS_PER_MODULE = MODULE_LENGTH / CHANNELS_PER_LED };
+
+/**
+ * @brief Maps the global LED-IDs of the protocol to the channels of the boards.
+ *
+ * The boards are numbered in the order of the buses and their addresses; the LED
+ * with the ID i is on board i / LEDS_PER_MODULE and uses the channels starting at
+ * CHANNELS_PER_LED * (i % LEDS_PER_MODULE) for red, green and blue. The alpha-value
+ * scales the brightness of all three channels.
+ */
+class led_map {
+public:
+	/**
+	 * @brief Creates the mapping for some buses.
+	 * @param buses the buses, the map takes ownership of them
+	 */
+	explicit led_map(std::vector<std::unique_ptr<bus>> buses);
+	
+	/**
+	 * @brief the number of LEDs that can be adressed
+	 */
+	std::size_t led_count() const;
+	
+	/**
+	 * @brief Sets the color of an LED; IDs without a board are ignored.
+	 * @param id the ID of the LED
+	 * @param col the new color
+	 */
+	void set_led(uint16_t id, const vlpp::rgba_color& col);
+	
+	/**
+	 * @brief Sends the changes to the boards and lets them display them.
+	 */
+	void strobe();
+	
+	/**
+	 * @brief the buses
+	 */
+	const std::vector<std::unique_ptr<bus>>& buses() const;
+	
+	/**
+	 * @brief the total number of strobes
+	 */
+	std::size_t strobes() const;
+	
+private:
+	struct location {
+		bus* target;
+		std::size_t module;
+	};
+	
+	std::vector<std::unique_ptr<bus>> _buses;
+	std::vector<location> _modules;
+	std::size_t _strobes = 0;
+};
+
+#endif // LED_MAP_HPP
@@ -0,0 +1,186 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+
+#include "../lib/client.hpp"
+#include "../lib/protocol.hpp"
+#include "../util/ids.hpp"
+
+#include "bus.hpp"
+#include "led_map.hpp"
+#include "server.hpp"
+#include "shm_source.hpp"
+#include "udp_receiver.hpp"
+
+namespace {
+
+/*
+ * Parses a bus-description like “/dev/ttyUSB0=1-5”.
+ */
+std::unique_ptr<bus> make_bus(boost::asio::io_service& io_service, const std::string& description,
+		unsigned baud_rate) {
+	auto separator = description.rfind('=');
+	if (separator == std::string::npos) {
+		throw std::invalid_argument("invalid bus: “" + description + "”");
+	}
+	return std::unique_ptr<bus>(new bus(io_service, description.substr(0, separator), baud_rate,
+		str_to_ids(description.substr(separator + 1))));
+}
+
+/*
+ * Prints the throughput of the server every interval.
+ */
+void print_stats(boost::asio::steady_timer& timer, std::chrono::seconds interval,
+		const led_map& leds, const udp_receiver* datagrams, std::size_t last_strobes,
+		std::vector<std::size_t> last_bytes) {
+	timer.expires_from_now(interval);
+	timer.async_wait([&timer, interval, &leds, datagrams, last_strobes, last_bytes]
+			(const boost::system::error_code& e) mutable {
+		if (e) {
+			return;
+		}
+		std::cout << "strobes/s: " << (leds.strobes() - last_strobes) / interval.count();
+		last_strobes = leds.strobes();
+		for (std::size_t i = 0; i < leds.buses().size(); ++i) {
+			auto& b = *leds.buses()[i];
+			std::cout << ", " << b.name() << ": "
+			          << (b.bytes_written() - last_bytes[i]) / interval.count() << " bytes/s";
+			last_bytes[i] = b.bytes_written();
+		}
+		if (datagrams) {
+			std::cout << ", stale datagrams: " << datagrams->stale_datagrams();
+		}
+		std::cout << std::endl;
+		print_stats(timer, interval, leds, datagrams, last_strobes, last_bytes);
+	});
+}
+
+} // anonymous namespace
+
+/*
+ * this program forwards the commands of the clients to the LED-boards
+ */
+int main(int argc, char** argv) {
+	using std::string;
+	namespace bpo = boost::program_options;
+	
+	uint16_t port;
+	string unix_path;
+	string shm_name;
+	std::vector<string> tokens;
+	std::vector<string> bus_descriptions;
+	unsigned baud_rate;
+	unsigned stats_interval;
+	
+	try {
+		bpo::options_description desc;
+		desc.add_options()
+			("help,h", "print this help")
+			("port,p", bpo::value<uint16_t>(&port)->default_value(vlpp::client::DEFAULT_PORT),
+			 "sets the server-port")
+			("udp", "additionally receives datagrams from clients in udp-mode on the same port")
+			("unix,u", bpo::value<string>(&unix_path),
+			 "additionally listens on a unix-domain-socket at this path")
+			("shm", bpo::value<string>(&shm_name),
+			 "creates a shared-memory-framebuffer with this name, e.g. “/vaporlight”")
+			("token,t", bpo::value<std::vector<string>>(&tokens)->composing(),
+			 "adds a valid authentication-token (default: “sixteen letters.”)")
+			("bus,b", bpo::value<std::vector<string>>(&bus_descriptions)->composing(),
+			 "adds a bus as <device>=<board-addresses>, e.g. “/dev/ttyUSB0=1-5”; "
+			 "use “pty” as device to create a pseudo-terminal")
+			("baud,B", bpo::value<unsigned>(&baud_rate)->default_value(500000),
+			 "sets the baud-rate of the serial devices")
+			("stats,S", bpo::value<unsigned>(&stats_interval)->default_value(0),
+			 "print statistics every n seconds");
+		
+		bpo::variables_map vm;
+		bpo::store(bpo::parse_command_line(argc, argv, desc), vm);
+		bpo::notify(vm);
+		if (vm.count("help")) {
+			std::cout << desc << std::endl;
+			return 0;
+		}
+		if (bus_descriptions.empty()) {
+			std::cerr << "Error: You need to provide at least one bus." << std::endl;
+			return 1;
+		}
+		if (tokens.empty()) {
+			tokens.push_back("sixteen letters.");
+		}
+		for (auto& token: tokens) {
+			if (token.size() != vlpp::TOKEN_SIZE) {
+				std::cerr << "Error: invalid token-size: " << token.size() << std::endl;
+				return 1;
+			}
+		}
+		
+		boost::asio::io_service io_service;
+		
+		std::vector<std::unique_ptr<bus>> buses;
+		for (auto& description: bus_descriptions) {
+			buses.push_back(make_bus(io_service, description, baud_rate));
+		}
+		led_map leds(std::move(buses));
+		std::size_t first_led = 0;
+		for (auto& b: leds.buses()) {
+			std::size_t leds_on_bus = b->module_count() * LEDS_PER_MODULE;
+			std::cout << b->name() << ": LEDs " << first_led << "-"
+			          << first_led + leds_on_bus - 1 << std::endl;
+			first_led += leds_on_bus;
+		}
+		
+		server srv(io_service, leds, tokens, port, unix_path);
+		std::unique_ptr<udp_receiver> datagrams;
+		if (vm.count("udp")) {
+			datagrams.reset(new udp_receiver(io_service, leds, tokens, port));
+		}
+		std::unique_ptr<shm_source> framebuffer;
+		if (!shm_name.empty()) {
+			framebuffer.reset(new shm_source(io_service, leds, shm_name));
+		}
+		
+		boost::asio::signal_set signals(io_service, SIGINT, SIGTERM);
+		signals.async_wait([&io_service](const boost::system::error_code&, int) {
+			io_service.stop();
+		});
+		
+		boost::asio::steady_timer stats_timer(io_service);
+		if (stats_interval) {
+			print_stats(stats_timer, std::chrono::seconds(stats_interval), leds, datagrams.get(), 0,
+				std::vector<std::size_t>(leds.buses().size(), 0));
+		}
+		
+		io_service.run();
+	}
+	catch (std::exception& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,99 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "server.hpp"
+
+#include "session.hpp"
+
+#include <unistd.h>
+
+using boost::asio::ip::tcp;
+using boost::asio::local::stream_protocol;
+
+server::server(boost::asio::io_service& io_service, led_map& leds,
+		std::vector<std::string> tokens, uint16_t port, const std::string& unix_path):
+	_io_service(io_service),
+	_acceptor(io_service, tcp::endpoint(tcp::v4(), port)),
+	_local_acceptor(io_service),
+	_accept_timer(io_service),
+	_local_accept_timer(io_service),
+	_unix_path(unix_path),
+	_leds(leds),
+	_tokens(std::move(tokens)) {
+	accept();
+	if (!_unix_path.empty()) {
+		// a socket-file left behind by a previous run would make bind() fail:
+		::unlink(_unix_path.c_str());
+		_local_acceptor.open();
+		_local_acceptor.bind(stream_protocol::endpoint(_unix_path));
+		_local_acceptor.listen();
+		accept_local();
+	}
+}
+
+server::~server() {
+	if (_local_acceptor.is_open()) {
+		::unlink(_unix_path.c_str());
+	}
+}
+
+void server::accept() {
+	auto client = std::make_shared<session>(_io_service, _leds, _tokens);
+	_acceptor.async_accept(client->socket(), [this, client](const boost::system::error_code& e) {
+		if (e == boost::asio::error::operation_aborted) {
+			return;
+		}
+		if (e) {
+			retry_accept(_accept_timer, &server::accept);
+			return;
+		}
+		boost::system::error_code option_error;
+		client->socket().set_option(tcp::no_delay(true), option_error);
+		// otherwise the client is most likely gone already, so its session is dropped:
+		if (!option_error) {
+			client->start();
+		}
+		accept();
+	});
+}
+
+void server::accept_local() {
+	auto client = std::make_shared<session>(_io_service, _leds, _tokens);
+	_local_acceptor.async_accept(client->socket(), [this, client](const boost::system::error_code& e) {
+		if (e == boost::asio::error::operation_aborted) {
+			return;
+		}
+		if (e) {
+			retry_accept(_local_accept_timer, &server::accept_local);
+			return;
+		}
+		client->start();
+		accept_local();
+	});
+}
+
+void server::retry_accept(boost::asio::steady_timer& timer, void (server::*accept)()) {
+	// errors like running out of file-descriptors last a while, accepting again
+	// right away would just spin:
+	timer.expires_from_now(std::chrono::milliseconds(ACCEPT_RETRY_DELAY));
+	timer.async_wait([this, accept](const boost::system::error_code& e) {
+		if (!e) {
+			(this->*accept)();
+		}
+	});
+}
@@ -0,0 +1,74 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+#include "led_map.hpp"
+
+/**
+ * @brief Accepts the clients and creates a session for each of them.
+ *
+ * All clients share the same LEDs; a strobe of any client sends the changes
+ * of all of them.
+ */
+class server {
+public:
+	/**
+	 * @brief Starts listening.
+	 * @param io_service the io_service that runs the server
+	 * @param leds the LEDs
+	 * @param tokens the valid authentication-tokens
+	 * @param port the tcp-port
+	 * @param unix_path if not empty, clients on the same host may also connect
+	 *                  to a unix-domain-socket at this path; an existing file
+	 *                  at this path is replaced
+	 */
+	server(boost::asio::io_service& io_service, led_map& leds,
+		std::vector<std::string> tokens, uint16_t port, const std::string& unix_path = "");
+	
+	~server();
+	
+	server(const server&) = delete;
+	server &operator=(const server&) = delete;
+	
+private:
+	void accept();
+	void accept_local();
+	void retry_accept(boost::asio::steady_timer& timer, void (server::*accept)());
+	
+	// the delay in milliseconds before accepting again after an error:
+	enum { ACCEPT_RETRY_DELAY = 100 };
+	
+	boost::asio::io_service& _io_service;
+	boost::asio::ip::tcp::acceptor _acceptor;
+	boost::asio::local::stream_protocol::acceptor _local_acceptor;
+	boost::asio::steady_timer _accept_timer;
+	boost::asio::steady_timer _local_accept_timer;
+	std::string _unix_path;
+	led_map& _leds;
+	std::vector<std::string> _tokens;
+};
+
+#endif // SERVER_HPP
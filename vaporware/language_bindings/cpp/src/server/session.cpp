@@ -0,0 +1,190 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "session.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "../lib/protocol.hpp"
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+// a client must not stop a session for longer than this:
+const std::chrono::seconds MAX_STROBE_DELAY(10);
+
+} // anonymous namespace
+
+session::session(boost::asio::io_service& io_service, led_map& leds,
+		const std::vector<std::string>& tokens):
+	_socket(io_service), _leds(leds), _tokens(tokens), _strobe_timer(io_service) {}
+
+boost::asio::generic::stream_protocol::socket& session::socket() {
+	return _socket;
+}
+
+void session::start() {
+	read();
+}
+
+void session::authenticate(const std::string& token) {
+	if (std::find(_tokens.begin(), _tokens.end(), token) == _tokens.end()) {
+		throw protocol_error("invalid token");
+	}
+	_authenticated = true;
+}
+
+void session::set_led(uint16_t id, const vlpp::rgba_color& col) {
+	require_authentication();
+	_leds.set_led(id, col);
+}
+
+void session::set_range(uint16_t first, uint16_t last, const vlpp::rgba_color& col) {
+	require_authentication();
+	for (std::size_t id = first; id <= last; ++id) {
+		_leds.set_led(static_cast<uint16_t>(id), col);
+	}
+}
+
+void session::set_leds(uint16_t first, const vlpp::rgba_color* colors, std::size_t count) {
+	require_authentication();
+	for (std::size_t i = 0; i < count; ++i) {
+		_leds.set_led(static_cast<uint16_t>(first + i), colors[i]);
+	}
+}
+
+void session::strobe() {
+	require_authentication();
+	_leds.strobe();
+}
+
+void session::strobe_at(uint64_t time) {
+	require_authentication();
+	clock::time_point when{std::chrono::nanoseconds(time)};
+	auto now = clock::now();
+	if (when <= now) {
+		_leds.strobe();
+		return;
+	}
+	if (when - now > MAX_STROBE_DELAY) {
+		throw protocol_error("strobe too far in the future");
+	}
+	_strobe_scheduled = true;
+	_strobe_timer.expires_at(when);
+	auto self = shared_from_this();
+	_strobe_timer.async_wait([self](const boost::system::error_code& e) {
+		if (e) {
+			return;
+		}
+		self->_strobe_scheduled = false;
+		self->_leds.strobe();
+		if (self->resume()) {
+			self->read();
+		}
+	});
+}
+
+void session::ping(uint64_t client_time) {
+	require_authentication();
+	uint64_t now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		clock::now().time_since_epoch()).count());
+	char reply[vlpp::PING_REPLY_SIZE];
+	reply[0] = static_cast<char>(vlpp::opcodes::PING);
+	vlpp::write_timestamp(client_time, reply + 1);
+	vlpp::write_timestamp(now, reply + 1 + vlpp::TIMESTAMP_SIZE);
+	_replies.insert(_replies.end(), reply, reply + sizeof(reply));
+	if (!_replying) {
+		send_replies();
+	}
+}
+
+void session::send_replies() {
+	_replying = true;
+	std::swap(_replies, _sending);
+	auto self = shared_from_this();
+	boost::asio::async_write(_socket, boost::asio::buffer(_sending),
+		[self](const boost::system::error_code& e, std::size_t) {
+			self->_sending.clear();
+			self->_replying = false;
+			if (!e && !self->_replies.empty()) {
+				self->send_replies();
+			}
+		});
+}
+
+void session::read() {
+	auto self = shared_from_this();
+	_socket.async_read_some(boost::asio::buffer(_buffer),
+		[self](const boost::system::error_code& e, std::size_t length) {
+			if (e) {
+				return;
+			}
+			try {
+				self->received(length);
+			}
+			catch (protocol_error& err) {
+				std::cerr << "Error: dropping client: " << err.what() << std::endl;
+				return;
+			}
+			if (self->resume()) {
+				self->read();
+			}
+		});
+}
+
+void session::received(std::size_t length) {
+	// most of the time there is no incomplete command, so avoid copying:
+	if (_pending.empty()) {
+		std::size_t consumed = decode(_buffer.data(), length, *this);
+		_pending.assign(_buffer.data() + consumed, _buffer.data() + length);
+	}
+	else {
+		_pending.insert(_pending.end(), _buffer.data(), _buffer.data() + length);
+	}
+}
+
+/*
+ * Decodes the pending commands until a STROBE_AT has to wait or only an incomplete
+ * command is left; returns whether the session may read again.
+ */
+bool session::resume() {
+	std::size_t consumed;
+	do {
+		if (_strobe_scheduled) {
+			return false;
+		}
+		try {
+			consumed = decode(_pending.data(), _pending.size(), *this);
+		}
+		catch (protocol_error& err) {
+			std::cerr << "Error: dropping client: " << err.what() << std::endl;
+			return false;
+		}
+		_pending.erase(_pending.begin(), _pending.begin() + static_cast<std::ptrdiff_t>(consumed));
+	} while (consumed);
+	return true;
+}
+
+void session::require_authentication() const {
+	if (!_authenticated) {
+		throw protocol_error("not authenticated");
+	}
+}
@@ -0,0 +1,93 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SESSION_HPP
+#define SESSION_HPP
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+#include "decoder.hpp"
+#include "led_map.hpp"
+
+/**
+ * @brief The connection to one client.
+ *
+ * The session decodes the commands of the client and applies them to the LEDs;
+ * everything but AUTHENTICATE is rejected until the client has sent a valid token.
+ * While a STROBE_AT waits for its time, the session stops reading, so the
+ * following commands can't change the frame before it is executed.
+ */
+class session: public command_handler, public std::enable_shared_from_this<session> {
+public:
+	/**
+	 * @brief Creates an unconnected session.
+	 * @param io_service the io_service of the server
+	 * @param leds the LEDs the client controls
+	 * @param tokens the valid authentication-tokens
+	 */
+	session(boost::asio::io_service& io_service, led_map& leds,
+		const std::vector<std::string>& tokens);
+	
+	/**
+	 * @brief the socket (tcp or unix-domain), it must be connected before calling start()
+	 */
+	boost::asio::generic::stream_protocol::socket& socket();
+	
+	/**
+	 * @brief Starts reading; the session keeps itself alive until the client disconnects.
+	 */
+	void start();
+	
+	void authenticate(const std::string& token) override;
+	void set_led(uint16_t id, const vlpp::rgba_color& col) override;
+	void set_range(uint16_t first, uint16_t last, const vlpp::rgba_color& col) override;
+	void set_leds(uint16_t first, const vlpp::rgba_color* colors, std::size_t count) override;
+	void strobe() override;
+	void strobe_at(uint64_t time) override;
+	void ping(uint64_t client_time) override;
+	
+private:
+	enum { READ_SIZE = 65536 };
+	
+	void read();
+	void received(std::size_t length);
+	bool resume();
+	void send_replies();
+	void require_authentication() const;
+	
+	boost::asio::generic::stream_protocol::socket _socket;
+	led_map& _leds;
+	const std::vector<std::string>& _tokens;
+	bool _authenticated = false;
+	std::array<char, READ_SIZE> _buffer;
+	// the beginning of an incomplete command, or the commands after a STROBE_AT:
+	std::vector<char> _pending;
+	boost::asio::steady_timer _strobe_timer;
+	bool _strobe_scheduled = false;
+	// the answers to PING that are waiting for the one that is being sent:
+	std::vector<char> _replies;
+	std::vector<char> _sending;
+	bool _replying = false;
+};
+
+#endif // SESSION_HPP
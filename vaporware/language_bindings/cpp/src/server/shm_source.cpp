@@ -0,0 +1,130 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "shm_source.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace shm = vlpp::shm;
+
+shm_source::shm_source(boost::asio::io_service& io_service, led_map& leds, const std::string& name):
+	_io_service(io_service),
+	_leds(leds),
+	_name(name),
+	_posted(false),
+	_stop(false),
+	_frame(leds.led_count()) {
+	auto led_count = static_cast<uint32_t>(leds.led_count());
+	_size = shm::segment_size(led_count);
+	// a framebuffer left behind by a previous run might have another size:
+	shm_unlink(_name.c_str());
+	int fd = shm_open(_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0660);
+	if (fd < 0) {
+		throw std::system_error(errno, std::system_category(), "cannot create " + _name);
+	}
+	if (ftruncate(fd, static_cast<off_t>(_size)) < 0) {
+		int error = errno;
+		close(fd);
+		shm_unlink(_name.c_str());
+		throw std::system_error(error, std::system_category(), "cannot resize " + _name);
+	}
+	void* mapping = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	int error = errno;
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		shm_unlink(_name.c_str());
+		throw std::system_error(error, std::system_category(), "cannot map " + _name);
+	}
+	// the memory is zeroed, so all slots are empty and nothing is published:
+	_segment = new(mapping) shm::header();
+	_segment->version = shm::VERSION;
+	_segment->led_count = led_count;
+	_segment->slot_count = shm::SLOT_COUNT;
+	_segment->magic.store(shm::MAGIC, std::memory_order_release);
+	_waiter = std::thread([this] {
+		wait_for_frames();
+	});
+}
+
+shm_source::~shm_source() {
+	_stop = true;
+	shm::ring_doorbell(_segment);
+	_waiter.join();
+	munmap(_segment, _size);
+	shm_unlink(_name.c_str());
+}
+
+void shm_source::wait_for_frames() {
+	// wake up regularly to notice _stop even if the doorbell is missed:
+	const timespec timeout = {0, 100000000};
+	while (!_stop) {
+		// announce the sleep before checking for frames, so a publisher that
+		// doesn't see us waiting has already published the frame we check for:
+		_segment->waiters.fetch_add(1, std::memory_order_seq_cst);
+		auto bell = _segment->doorbell.load(std::memory_order_seq_cst);
+		if (_segment->published.load(std::memory_order_seq_cst) == _seen) {
+			shm::wait_doorbell(_segment, bell, timeout);
+		}
+		_segment->waiters.fetch_sub(1, std::memory_order_relaxed);
+		auto published = _segment->published.load(std::memory_order_acquire);
+		if (published != _seen) {
+			_seen = published;
+			// if the io_service hasn't applied the last frame yet, it will take this one:
+			if (!_posted.exchange(true)) {
+				_io_service.post([this] {
+					apply_frame();
+				});
+			}
+		}
+	}
+}
+
+void shm_source::apply_frame() {
+	_posted = false;
+	uint64_t frame;
+	while (true) {
+		frame = _segment->published.load(std::memory_order_acquire);
+		if (frame == 0) {
+			return;
+		}
+		auto& sequence = shm::slot_sequence(_segment, frame);
+		if (sequence.load(std::memory_order_acquire) != frame) {
+			continue;
+		}
+		std::memcpy(_frame.data(), shm::slot_colors(_segment, frame),
+			_frame.size() * sizeof(vlpp::rgba_color));
+		// the copy must be complete before the sequence is checked again:
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (sequence.load(std::memory_order_relaxed) == frame) {
+			break;
+		}
+		// the publisher has overtaken us, so try again with a newer frame
+	}
+	for (std::size_t i = 0; i < _frame.size(); ++i) {
+		_leds.set_led(static_cast<uint16_t>(i), _frame[i]);
+	}
+	_leds.strobe();
+}
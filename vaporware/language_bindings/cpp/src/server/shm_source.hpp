@@ -0,0 +1,76 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SHM_SOURCE_HPP
+#define SHM_SOURCE_HPP
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+#include "../lib/rgba_color.hpp"
+#include "../lib/shm_layout.hpp"
+
+#include "led_map.hpp"
+
+/**
+ * @brief A shared-memory-framebuffer that local processes can publish frames to.
+ *
+ * The framebuffer is created with the permissions 0660 and removed again by the
+ * destructor; see vlpp::shm_publisher for the other side. A thread sleeps on the
+ * doorbell of the framebuffer and lets the io_service apply the newest frame to
+ * the LEDs and strobe them, frames that arrive in the meantime are skipped.
+ */
+class shm_source {
+public:
+	/**
+	 * @brief Creates the framebuffer and starts waiting for frames.
+	 * @param io_service the io_service that runs the server
+	 * @param leds the LEDs, the framebuffer contains all of them
+	 * @param name the name of the shared-memory-object, eg "/vaporlight"
+	 * @throws std::system_error if the framebuffer cannot be created
+	 */
+	shm_source(boost::asio::io_service& io_service, led_map& leds, const std::string& name);
+	
+	~shm_source();
+	
+	shm_source(const shm_source&) = delete;
+	shm_source &operator=(const shm_source&) = delete;
+	
+private:
+	void wait_for_frames();
+	void apply_frame();
+	
+	boost::asio::io_service& _io_service;
+	led_map& _leds;
+	std::string _name;
+	vlpp::shm::header* _segment = nullptr;
+	std::size_t _size = 0;
+	// the frame that was seen last by the waiting thread:
+	uint64_t _seen = 0;
+	// whether apply_frame() is already posted:
+	std::atomic<bool> _posted;
+	std::atomic<bool> _stop;
+	std::vector<vlpp::rgba_color> _frame;
+	std::thread _waiter;
+};
+
+#endif // SHM_SOURCE_HPP
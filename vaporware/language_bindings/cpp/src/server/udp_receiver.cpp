@@ -0,0 +1,135 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "udp_receiver.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "../lib/protocol.hpp"
+
+using boost::asio::ip::udp;
+
+namespace {
+
+uint64_t read_be(const char* data, std::size_t size) {
+	uint64_t value = 0;
+	for (std::size_t i = 0; i < size; ++i) {
+		value = value << 8 | static_cast<uint8_t>(data[i]);
+	}
+	return value;
+}
+
+} // anonymous namespace
+
+udp_receiver::udp_receiver(boost::asio::io_service& io_service, led_map& leds,
+		const std::vector<std::string>& tokens, uint16_t port):
+	_socket(io_service, udp::endpoint(udp::v4(), port)),
+	_leds(leds) {
+	for (auto& token: tokens) {
+		_digests.push_back(vlpp::token_digest(token));
+	}
+	receive();
+}
+
+void udp_receiver::authenticate(const std::string&) {
+	throw protocol_error("AUTHENTICATE in a datagram");
+}
+
+void udp_receiver::set_led(uint16_t id, const vlpp::rgba_color& col) {
+	_leds.set_led(id, col);
+}
+
+void udp_receiver::set_range(uint16_t first, uint16_t last, const vlpp::rgba_color& col) {
+	for (std::size_t id = first; id <= last; ++id) {
+		_leds.set_led(static_cast<uint16_t>(id), col);
+	}
+}
+
+void udp_receiver::set_leds(uint16_t first, const vlpp::rgba_color* colors, std::size_t count) {
+	for (std::size_t i = 0; i < count; ++i) {
+		_leds.set_led(static_cast<uint16_t>(first + i), colors[i]);
+	}
+}
+
+void udp_receiver::strobe() {
+	throw protocol_error("STROBE in a datagram");
+}
+
+void udp_receiver::strobe_at(uint64_t) {
+	throw protocol_error("STROBE_AT in a datagram");
+}
+
+void udp_receiver::ping(uint64_t) {
+	throw protocol_error("PING in a datagram");
+}
+
+std::size_t udp_receiver::stale_datagrams() const {
+	return _stale;
+}
+
+void udp_receiver::receive() {
+	_socket.async_receive_from(boost::asio::buffer(_buffer), _sender,
+		[this](const boost::system::error_code& e, std::size_t length) {
+			if (e == boost::asio::error::operation_aborted) {
+				return;
+			}
+			if (!e) {
+				try {
+					received(length);
+				}
+				catch (protocol_error& err) {
+					std::cerr << "Error: dropping datagram from " << _sender << ": "
+					          << err.what() << std::endl;
+				}
+			}
+			receive();
+		});
+}
+
+void udp_receiver::received(std::size_t length) {
+	if (length < vlpp::DATAGRAM_HEADER_SIZE) {
+		throw protocol_error("datagram too short");
+	}
+	auto sequence = static_cast<uint32_t>(read_be(_buffer.data(), 4));
+	auto digest = read_be(_buffer.data() + 4, 8);
+	auto flags = static_cast<uint8_t>(_buffer[12]);
+	if (std::find(_digests.begin(), _digests.end(), digest) == _digests.end()) {
+		throw protocol_error("invalid token");
+	}
+	auto newest = _sequences.find(_sender);
+	if (newest == _sequences.end()) {
+		_sequences.emplace(_sender, sequence);
+	}
+	// compare in serial-number-arithmetic, so the sequence may wrap around:
+	else if (static_cast<int32_t>(sequence - newest->second) < 0) {
+		++_stale;
+		return;
+	}
+	else {
+		newest->second = sequence;
+	}
+	const char* commands = _buffer.data() + vlpp::DATAGRAM_HEADER_SIZE;
+	std::size_t size = length - vlpp::DATAGRAM_HEADER_SIZE;
+	if (decode(commands, size, *this) != size) {
+		throw protocol_error("incomplete command");
+	}
+	if (flags & vlpp::DATAGRAM_LAST) {
+		_leds.strobe();
+	}
+}
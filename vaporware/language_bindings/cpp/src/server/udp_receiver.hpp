@@ -0,0 +1,84 @@
+/*
+ *  This file is part of vaporpp.
+ *
+ *  vaporpp is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  vaporpp is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with vaporpp.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef UDP_RECEIVER_HPP
+#define UDP_RECEIVER_HPP
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+#include "decoder.hpp"
+#include "led_map.hpp"
+
+/**
+ * @brief Receives the datagrams of clients in udp-mode.
+ *
+ * Every datagram is decoded on its own (see vlpp::DATAGRAM_SIZE for the layout); datagrams
+ * with an unknown token-digest or a sequence-number older than the newest one of the
+ * same client are dropped, so a late frame never overwrites a newer one.
+ */
+class udp_receiver: public command_handler {
+public:
+	/**
+	 * @brief Starts receiving.
+	 * @param io_service the io_service of the server
+	 * @param leds the LEDs the clients control
+	 * @param tokens the valid authentication-tokens
+	 * @param port the udp-port
+	 */
+	udp_receiver(boost::asio::io_service& io_service, led_map& leds,
+		const std::vector<std::string>& tokens, uint16_t port);
+	
+	udp_receiver(const udp_receiver&) = delete;
+	udp_receiver &operator=(const udp_receiver&) = delete;
+	
+	void authenticate(const std::string& token) override;
+	void set_led(uint16_t id, const vlpp::rgba_color& col) override;
+	void set_range(uint16_t first, uint16_t last, const vlpp::rgba_color& col) override;
+	void set_leds(uint16_t first, const vlpp::rgba_color* colors, std::size_t count) override;
+	void strobe() override;
+	void strobe_at(uint64_t time) override;
+	void ping(uint64_t client_time) override;
+	
+	/**
+	 * @brief the number of datagrams that were dropped because they were too late
+	 */
+	std::size_t stale_datagrams() const;
+	
+private:
+	enum { RECEIVE_SIZE = 65536 };
+	
+	void receive();
+	void received(std::size_t length);
+	
+	boost::asio::ip::udp::socket _socket;
+	boost::asio::ip::udp::endpoint _sender;
+	led_map& _leds;
+	std::vector<uint64_t> _digests;
+	// the newest sequence-number of every client:
+	std::map<boost::asio::ip::udp::endpoint, uint32_t> _sequences;
+	std::size_t _stale = 0;
+	std::array<char, RECEIVE_SIZE> _buffer;
+};
+
+#endif // UDP_RECEIVER_HPP
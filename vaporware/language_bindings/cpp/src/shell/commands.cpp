@@ -28,6 +28,23 @@ void set_leds(vlpp::client& cl, const std::string& leds, const std::string& colo
 	cl.set_leds(str_to_ids(leds), col);
 }
 
+void print_stats(const vlpp::client& cl) {
+	auto stats = cl.stats();
+	auto microseconds = [](double nanoseconds) {
+		return nanoseconds / 1000;
+	};
+	const auto& latency = stats.flush_latency;
+	std::cout << "frames: " << stats.frames << "\n"
+	          << "records: " << stats.records << "\n"
+	          << "bytes sent: " << stats.bytes_sent << "\n"
+	          << "bytes saved: " << stats.bytes_saved << "\n"
+	          << "writes: " << stats.writes << "\n"
+	          << "flush-latency: mean " << microseconds(latency.mean()) << "µs"
+	          << ", median " << microseconds(latency.percentile(0.5)) << "µs"
+	          << ", p99 " << microseconds(latency.percentile(0.99)) << "µs"
+	          << ", max " << microseconds(latency.max()) << "µs" << std::endl;
+}
+
 void print_cli_help(){
 	std::cout << "Commands: \n\n"
 		     "set|s <LEDs> <rgba-colorcode>\n"
@@ -36,6 +53,8 @@ void print_cli_help(){
 		     "\tbuffers commands to set some leds to a color\n"
 		     "flush|f\n"
 		     "\texecutes the buffered commands\n"
+		     "stats\n"
+		     "\tprints how many frames and bytes were sent and how long flushing took\n"
 		     "quit|q\n"
 		     "\tquit the programm\n"
 		     "help|h\n"
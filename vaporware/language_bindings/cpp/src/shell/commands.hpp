@@ -33,6 +33,12 @@
 void set_leds(vlpp::client& cl, const std::string& leds, const std::string& color);
 
 
+/**
+ * @brief Prints the statistics of the client.
+ * @param cl the client
+ */
+void print_stats(const vlpp::client& cl);
+
 /**
  * @brief Prints a help-message for the commandline.
  */
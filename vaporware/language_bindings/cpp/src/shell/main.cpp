@@ -41,6 +41,7 @@ int main(int argc, char**argv) {
 	desc.add_options()
 	("help,h", "print this help")
 	("verbose,v", "be verbose")
+	("reconnect,r", "reconnect if the connection is lost instead of quitting")
 	("token,t", bpo::value<std::string>(&token), "sets the authentication-token")
 	("server,s", bpo::value<std::string>(&server), "sets the servername")
 	("port,p", bpo::value<uint16_t>(&port)->default_value(vlpp::client::DEFAULT_PORT), "sets the server-port");
@@ -65,6 +66,7 @@ int main(int argc, char**argv) {
 	}
 	
 	vlpp::client client(server, token, port);
+	client.set_resilient(vm.count("reconnect"));
 	
 	string line;
 	std::map<string, string> argmap = {
@@ -108,6 +110,9 @@ int main(int argc, char**argv) {
 		else if(cmd.first == "flush"){
 			client.flush();
 		}
+		else if(cmd.first == "stats"){
+			print_stats(client);
+		}
 		else if(cmd.first == "help"){
 			print_cli_help();
 		}
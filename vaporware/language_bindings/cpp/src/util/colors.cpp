@@ -1,7 +1,12 @@
 #include "colors.hpp"
 
+#include <array>
+#include <cmath>
 #include <sstream>
 #include <set>
+#include <stdexcept>
+
+#include "../lib/color_space.hpp"
 
 enum:uint8_t{ CHANNEL_B_MAX = UINT8_MAX };
 
@@ -54,11 +59,49 @@ std::vector<rgba_color> str_to_cols(const std::string& str){
 	return {colors.begin(), colors.end()};
 }
 
+// parses the three components of a color like “hsv:210:0.8:1”; the hue may be any
+// number, the other two must be in [0, 1]:
+static std::array<float, 3> str_to_components(const std::string& str){
+	std::array<float, 3> components;
+	std::istringstream data(str.substr(4));
+	std::string tmp;
+	for(std::size_t i = 0; i < components.size(); ++i){
+		if(!getline(data, tmp, ':')){
+			throw std::invalid_argument("invalid color: “" + str + "”");
+		}
+		std::size_t parsed = 0;
+		try{
+			components[i] = std::stof(tmp, &parsed);
+		}
+		// std::invalid_argument for garbage or std::out_of_range for huge values:
+		catch(std::logic_error&){
+			throw std::invalid_argument("invalid color: “" + str + "”");
+		}
+		// std::stof accepts “nan”, “inf” and trailing garbage like “1x”:
+		if(parsed != tmp.size() || !std::isfinite(components[i])
+				|| (i > 0 && (components[i] < 0 || components[i] > 1))){
+			throw std::invalid_argument("invalid color: “" + str + "”");
+		}
+	}
+	if(getline(data, tmp, ':')){
+		throw std::invalid_argument("invalid color: “" + str + "”");
+	}
+	return components;
+}
+
 vlpp::rgba_color str_to_col(const std::string& str){
 	auto col_map_it = COLOR_MAP.find(str);
 	if(col_map_it != COLOR_MAP.end()){
 		return col_map_it->second;
 	}
+	else if(str.compare(0, 4, "hsv:") == 0){
+		auto c = str_to_components(str);
+		return from_hsv(hsv_color{c[0], c[1], c[2]});
+	}
+	else if(str.compare(0, 4, "hsl:") == 0){
+		auto c = str_to_components(str);
+		return from_hsl(hsl_color{c[0], c[1], c[2]});
+	}
 	else{
 		return {str};
 	}
@@ -15,6 +15,10 @@ std::vector<vlpp::rgba_color> str_to_cols(const std::string& str);
 
 /**
  * @brief converts a string to a color.
+ *
+ * Besides names and hex-codes this accepts HSV and HSL, like “hsv:210:0.8:1” for
+ * the hue in degrees, the saturation and the value; the latter two must be in [0, 1].
+ *
  * @param str the string
  * @return the color that was represented by the string
  */